@@ -0,0 +1,103 @@
+#ifndef ATTACKS_HH
+#define ATTACKS_HH
+
+#include "utils.hpp"
+
+//  Attack lookups on the board bitmaps, the squares being the index of their bit: 8*i + 7 - j, with i = 0 the 8th rank and j = 0 the a-file.
+//  The knight and king attacks are taken from tables. The sliding pieces use a ray table for each direction, cut at the first piece found, which is the nearest set bit of the ray.
+//      Classical Approach: [https://www.chessprogramming.org/Classical_Approach]
+class Attacks {
+public:
+    static constexpr uint64_t FILE_A = 0x8080808080808080;
+    static constexpr uint64_t FILE_H = 0x0101010101010101;
+
+    static uint64_t knight(int square) { return KNIGHT_ATTACKS[square]; }
+    static uint64_t king(int square) { return KING_ATTACKS[square]; }
+
+    //  Returns the squares attacked by all the pawns of the color. The white pawns move to the lower bits and the black ones to the higher bits
+    static uint64_t pawns(uint64_t pawns, PieceColor col) {
+        if (col == WHITE) return ((pawns & ~FILE_A) >> 7) | ((pawns & ~FILE_H) >> 9);
+        return ((pawns & ~FILE_A) << 9) | ((pawns & ~FILE_H) << 7);
+    }
+
+    //  The occupied bitmap has the pieces that block the sliding pieces, the first one found in each direction is attacked
+    static uint64_t bishop(int square, uint64_t occupied) {
+        return ray(square, occupied, NORTH_EAST) | ray(square, occupied, NORTH_WEST) | ray(square, occupied, SOUTH_EAST) | ray(square, occupied, SOUTH_WEST);
+    }
+    static uint64_t rook(int square, uint64_t occupied) {
+        return ray(square, occupied, NORTH) | ray(square, occupied, SOUTH) | ray(square, occupied, EAST) | ray(square, occupied, WEST);
+    }
+    static uint64_t queen(int square, uint64_t occupied) {
+        return bishop(square, occupied) | rook(square, occupied);
+    }
+
+private:
+    typedef std::array<uint64_t, 64> SquareTable;
+
+    enum Direction : uint8_t {
+        NORTH,
+        SOUTH,
+        EAST,
+        WEST,
+        NORTH_EAST,
+        NORTH_WEST,
+        SOUTH_EAST,
+        SOUTH_WEST
+    };
+
+    //  The row and column increments of each direction, north being the 8th rank. The directions that move to higher bits have a positive 8*di - dj
+    static constexpr int DIRECTION_I[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+    static constexpr int DIRECTION_J[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+    static uint64_t ray(int square, uint64_t occupied, Direction direction) {
+        uint64_t attacks = RAYS[direction][square];
+        uint64_t blockers = attacks & occupied;
+        if (blockers) {
+            bool higherBits = 8 * DIRECTION_I[direction] - DIRECTION_J[direction] > 0;
+            int blocker = higherBits ? __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers);
+            attacks ^= RAYS[direction][blocker];
+        }
+        return attacks;
+    }
+
+    //  Builds the table of a leaper, from the row and column increments of its moves
+    static constexpr SquareTable buildLeaperTable(const int* di, const int* dj) {
+        SquareTable table{};
+        for (int square = 0; square < 64; ++square) {
+            int i = square / 8, j = 7 - square % 8;
+            for (int k = 0; k < 8; ++k) {
+                int newI = i + di[k], newJ = j + dj[k];
+                if (newI >= 0 && newI < 8 && newJ >= 0 && newJ < 8) table[square] |= uint64_t(1) << (8 * newI + 7 - newJ);
+            }
+        }
+        return table;
+    }
+
+    //  Builds the rays of each direction, from each square to the edge of the board, the square excluded
+    static constexpr std::array<SquareTable, 8> buildRays() {
+        std::array<SquareTable, 8> rays{};
+        for (int direction = 0; direction < 8; ++direction) {
+            for (int square = 0; square < 64; ++square) {
+                int i = square / 8 + DIRECTION_I[direction], j = 7 - square % 8 + DIRECTION_J[direction];
+                for (; i >= 0 && i < 8 && j >= 0 && j < 8; i += DIRECTION_I[direction], j += DIRECTION_J[direction])
+                    rays[direction][square] |= uint64_t(1) << (8 * i + 7 - j);
+            }
+        }
+        return rays;
+    }
+
+    static constexpr int KNIGHT_I_MOVE[8] = {2, 1, -1, -2, -2, -1, 1, 2};
+    static constexpr int KNIGHT_J_MOVE[8] = {1, 2, 2, 1, -1, -2, -2, -1};
+    static constexpr int KING_I_MOVE[8] = {1, 1, 1, 0, -1, -1, -1, 0};
+    static constexpr int KING_J_MOVE[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+    static const SquareTable KNIGHT_ATTACKS;
+    static const SquareTable KING_ATTACKS;
+    static const std::array<SquareTable, 8> RAYS;
+};
+
+inline constexpr Attacks::SquareTable Attacks::KNIGHT_ATTACKS = Attacks::buildLeaperTable(Attacks::KNIGHT_I_MOVE, Attacks::KNIGHT_J_MOVE);
+inline constexpr Attacks::SquareTable Attacks::KING_ATTACKS = Attacks::buildLeaperTable(Attacks::KING_I_MOVE, Attacks::KING_J_MOVE);
+inline constexpr std::array<Attacks::SquareTable, 8> Attacks::RAYS = Attacks::buildRays();
+
+#endif
@@ -2,12 +2,28 @@
 #define BOARD_HH
 
 #include "utils.hpp"
+#include "pieceSquareTables.hpp"
+#include "attacks.hpp"
 
 class Board {
 public:
+    //  A piece added to or removed from a square by the last move, the square being the index of its bit in the bitmaps. Used to update the evaluation terms kept outside the board.
+    struct PieceChange {
+        PieceType piece;
+        uint8_t square;
+        bool added;
+    };
+
+    //  The most pieces changed by a move, a castle: the king and the rook are removed and added
+    static constexpr int MAX_PIECE_CHANGES = 4;
+
     //  Creates a board with the pieces in the initial position.
     Board();
 
+    //  Copies the board, including its log, so the copy can make and undo moves independently of the original one.
+    Board(const Board& other);
+    Board& operator=(const Board& other);
+
     ~Board();
 
     //  Sets the board to the initial position.
@@ -16,6 +32,9 @@ public:
     //  Sets the board to the position passed as argument.
     void loadFEN(const std::string& fen);
 
+    //  Returns the FEN of the board. The halfmove clock isn't kept by the board, so it's always 0.
+    std::string getFEN() const;
+
     //  Returns the number of times the current board state has been repeated.
     int timesRepeated() const;
 
@@ -36,6 +55,16 @@ public:
     bool isCapture(const PieceMove& move) const;
     bool isTargeted(const PieceMove& move) const;
 
+    //  Returns true if the legal move passed as argument would leave the opponent in check, without making it. Discovered checks, promotions, en passant and castling are taken into account.
+    bool givesCheck(const PieceMove& move) const;
+
+    //  Static Exchange Evaluation: returns the material won by the player that makes the move once all the captures on its destination square are done, each player capturing with its least valuable piece and being able to stop. The values of the pieces are indexed by PieceType.
+    //      Static Exchange Evaluation: [https://www.chessprogramming.org/Static_Exchange_Evaluation]
+    int staticExchangeEvaluation(const PieceMove& move, const int* pieceValues) const;
+
+    //  Returns the bitmap of the pieces of type pt, see the bitmaps information below.
+    uint64_t getPieceBitmap(PieceType pt) const;
+
     //  Returns the number of pieces of the color passed as argument.
     int getAllPiecesCount() const;
     int getPlayerPiecesCount(PieceColor col) const;
@@ -46,20 +75,46 @@ public:
     int getQueensCount(PieceColor col) const;
     int getKingsCount(PieceColor col) const;
 
-    //  Returns the zobrist hash of the board.
+    //  Returns true if the player that will move next is in check.
+    bool isInCheck() const;
+
+    //  Returns the zobrist hash of the board, it is updated incrementally with each move.
     uint64_t getZobristHash() const;
 
+    //  Returns the zobrist hash of the pawns of both colors only, used to cache the evaluation of the pawn structure. It is updated incrementally with each move.
+    uint64_t getPawnHash() const;
+
+    //  Returns the material key: the number of pieces of each PieceType, 4 bits each, starting from the least significant bits in the PieceType order. Two boards have the same key if and only if they have the same material. It is updated incrementally with each move.
+    uint64_t getMaterialKey() const;
+
+    //  Returns the sum of the material and piece-square scores of all the pieces from white's perspective, packed with the midgame and endgame scores. It is updated incrementally with each move, see PieceSquareTables.
+    PackedScore getPieceSquareScore() const;
+
+    //  Returns the game phase, from PieceSquareTables::MAX_PHASE at the start to 0 when only pawns and kings are left. It is updated incrementally with each move.
+    int getPhase() const;
+
+    //  Returns the pieces added and removed by the last move, and their number. There are none after a null move or a new position.
+    const PieceChange* getPieceChanges() const;
+    int getPieceChangesCount() const;
+
     //  Makes a move in the board, updating all bitmaps and variables accordingly.
     void movePiece(PieceMove& move);
 
     //  Undoes a move in the board, updating all bitmaps and variables accordingly.
     void undoMove();
 
-    //  Returns all the legal moves for the current player's turn.
-    const std::set<PieceMove>& getCurrentLegalMoves() const;
+    //  Passes the turn to the opponent without moving any piece, used by the engine for null move pruning. The en passant square is cleared and the board state is not registered for the threefold repetition. Must not be called while in check.
+    //  Only the turn, the en passant square, the hash and the squares targeted by the player that passed are updated. The legal moves of the opponent are calculated the first time they are asked for, many null moves are cut by the transposition table or the quiescence search before that. Until then, a stalemate isn't detected.
+    void makeNullMove();
+
+    //  Undoes a null move, must be called right after makeNullMove, once the moves made after it have been undone.
+    void undoNullMove();
+
+    //  Returns all the legal moves for the current player's turn. After a null move, they are calculated here the first time.
+    const std::set<PieceMove>& getCurrentLegalMoves();
 
     //  Returns all the takes for the current player's turn.
-    void getCurrentTakes(std::set<PieceMove>& takes)const;
+    void getCurrentTakes(std::set<PieceMove>& takes);
 
     //  Prints the last move made.
     void printLastMove(); //TODO: should be const
@@ -71,19 +126,42 @@ private:
     PieceColor moveTurn; //The color of the player that will move next
     unsigned int moveCounter; //The number of moves that have been made
     std::set<PieceMove> legalMoves; //The set of legal moves for the current player
+    bool legalMovesPending; //True after a null move, until the legal moves are calculated
     PieceMove lastMove; //The last move made
 
-    //  Log of the boardState, static because there will be copies of the board, and the log should be the same for all of them. Those copies must not modify the log.
+    //  What a null move changes, restored when it's undone. If the legal moves have been calculated after the null move, the board is logged then, and it's restored from the log instead
+    struct NullMoveState {
+        uint64_t zobristHash;
+        uint64_t enPassant;
+        int pieceChangesCount;
+        uint64_t whiteTargetedSquares, whitePinnedSquares;
+        uint64_t blackTargetedSquares, blackPinnedSquares;
+    };
+    std::vector<NullMoveState> nullMoveLog; //One for each null move made and not undone yet
+
+    //  Log of the boardState, each board has its own one, so an engine can search a copy of the game board in another thread.
     //  Maps a board state, represented by its zobrist hash, to the number of times it has been repeated. 
     //  We will only store the zobrist hash because the possibility of two different board states having the same zobrist hash is negligible. Actualy we can calculate it, with the birthaday paradox. p = 1 - e^-((n*(n-1)) / (2*2^k)) where n is the number of board states, and k is the number of bits of the zobrist hash. For n = 2^20, k = 64, p ≈ 0.
-    static std::map<uint64_t, int> boardStateCounter;
-    static std::list<Board> boardLogList; //List of boards, used to undo moves
+    std::map<uint64_t, int> boardStateCounter;
+    std::list<Board> boardLogList; //List of boards, used to undo moves. The boards in the list have an empty log
     bool threefoldRepetition; //True if the same board state is repeated three times, false otherwise.
+    //  The zobrist table is static and only initialized once, so that the hashes of all the boards are the same during the whole program
     static struct ZobristTable {
         uint64_t zobristPieces[64][12]; //12 pieces, 64 squares
-        uint64_t zobristMoveTurn, zobristCastle, zobrsitEnPassant;
+        uint64_t zobristMoveTurn;
+        uint64_t zobristCastle[4]; //One for each castle right: white king side, white queen side, black king side, black queen side
+        uint64_t zobristEnPassant[8]; //One for each file
     }
     zobristTable;
+    uint64_t zobristHash; //The zobrist hash of the current board, updated incrementally
+    uint64_t pawnHash; //The zobrist hash of the pawns, updated incrementally
+    uint64_t materialKey; //The number of pieces of each type, updated incrementally
+
+    //  Evaluation terms, updated incrementally when a piece is added or removed
+    PackedScore pieceSquareScore; //Material and piece-square scores, from white's perspective
+    int phase; //The game phase, see PieceSquareTables::MAX_PHASE
+    PieceChange pieceChanges[MAX_PIECE_CHANGES]; //The pieces changed by the last move
+    int pieceChangesCount;
 
     //  Board result
     BoardResult boardResult; //The result of the game, if it is still ongoing, it will be NONE.
@@ -107,9 +185,21 @@ private:
     uint64_t blackPieces, blackTargetedSquares, blackPinnedSquares;
 
     //  Zobrist table, see also [https://en.wikipedia.org/wiki/Zobrist_hashing]
-    //  Initializes the zobristTable with random values.
+    //  Initializes the zobristTable with random values, only the first time it's called, even if several threads call it at the same time.
     void initializeZobristTable();
 
+    //  Calculates the zobrist hash of the board from scratch.
+    uint64_t calculateZobristHash() const;
+
+    //  Calculates the zobrist hash of the pawns from scratch.
+    uint64_t calculatePawnHash() const;
+
+    //  Returns the part of the zobrist hash that doesn't depend on the pieces: the move turn, the castle rights and the en passant square.
+    uint64_t stateZobristHash() const;
+
+    //  Calculates pieceSquareScore, phase and materialKey from scratch, and clears the piece changes.
+    void calculateEvaluationScores();
+
     //LEGAL MOVES CALCULATION related functions
 
     //  Updates the legalMoves set with all possible moves for the current player's turn. It also updtes the opponent's targetedSquares and pinnedSquares bitmaps.
@@ -159,24 +249,33 @@ private:
     void targetedByQueen(uint64_t bit);
     void targetedByKing(uint64_t bit);
 
+    //  Returns the pieces of both colors that attack the (i, j) square. Only the pieces in the occupied bitmap are taken into account, they are the ones that block the sliding pieces.
+    uint64_t getAttackers(int i, int j, uint64_t occupied) const;
+
 
     //MAKING A MOVE related functions
     
-    //  Makes the move in the board, only updates the bitmaps
+    //  Makes the move in the board, only updates the bitmaps and records the pieces changed
     void makeAMove(const PieceMove& move);
 
-    //  Removes the bit from the targetBitMap.
-    void removePiece(uint64_t& targetBitMap, uint64_t bit);
+    //  Removes the piece of type pt located in the bit, updating the bitmaps, the zobrist hash and the evaluation scores. The change is recorded in pieceChanges.
+    void removePiece(PieceType pt, uint64_t bit);
 
-    //  Adds the bit to the targetBitMap.
-    void addPiece(uint64_t& targetBitMap, PieceColor col, uint64_t bit);
+    //  Adds a piece of type pt in the bit, updating the bitmaps, the zobrist hash and the evaluation scores. The change is recorded in pieceChanges.
+    void addPiece(PieceType pt, uint64_t bit);
 
     //  Detects if a castle move is being done, if so, it will move the rook.
-    void manageCastleMove(uint64_t fromPieceBitmap, const PieceMove& move);
+    void manageCastleMove(PieceType fromPiece, const PieceMove& move);
 
     //  Adds to boardStateLog the current board state.
     void registerState();
 
+    //  Pushes a copy of the current board state, without its log, to boardLogList.
+    void logState();
+
+    //  Restores the board to the state of prevBoard, which has to be taken from boardLogList.
+    void restoreState(const Board& prevBoard);
+
 
     //BITMAPS related functions
     
@@ -0,0 +1,60 @@
+#ifndef CHESSCLOCK_HH
+#define CHESSCLOCK_HH
+
+#include "utils.hpp"
+
+class ChessClock {
+public:
+    //  Creates a disabled clock, the players will have unlimited time.
+    ChessClock();
+
+    //  Enables the clock, each player will start with initialTime and will get increment after each move.
+    void setTimeControl(std::chrono::milliseconds initialTime, std::chrono::milliseconds increment);
+
+    //  Returns true if the game is played with a clock.
+    bool isEnabled() const;
+
+    //  Starts counting the time of the player with the color col. The time of the current turn, if any, is not charged.
+    void start(PieceColor col);
+
+    //  Stops the clock of the player that was moving after making a move: the time used is subtracted from its remaining time, and the increment is added if the flag has not fallen. Returns the time used.
+    std::chrono::milliseconds stop();
+
+    //  Returns the color of the player whose time is running, NONE_COLOR if the clock is stopped.
+    PieceColor getRunningColor() const;
+
+    //  Returns the remaining time of the player with the color col, including the current turn.
+    std::chrono::milliseconds getRemaining(PieceColor col) const;
+
+    //  Returns the increment per move.
+    std::chrono::milliseconds getIncrement() const;
+
+    //  Returns true if the player with the color col has run out of time.
+    bool flagFell(PieceColor col) const;
+
+    //  Prints the time used in the last move and the remaining time of the player.
+    void printLastMove() const;
+
+    //  Prints the time per move statistics of both players.
+    void printStatistics() const;
+
+private:
+    bool enabled; //True if the game is played with a clock
+    std::chrono::milliseconds increment; //The time added after each move
+    std::chrono::milliseconds remaining[2]; //The remaining time of each player, indexed by PieceColor
+
+    PieceColor runningColor; //The player whose time is running
+    std::chrono::steady_clock::time_point turnStart; //When the current turn started
+    PieceColor lastMoveColor; //The player that made the last move
+    std::chrono::milliseconds lastMoveTime; //The time used in the last move
+
+    //  Time per move statistics of each player
+    int movesCount[2];
+    std::chrono::milliseconds totalTime[2];
+    std::chrono::milliseconds maxTime[2];
+
+    //  Returns the time elapsed in the current turn.
+    std::chrono::milliseconds currentTurnTime() const;
+};
+
+#endif
@@ -2,23 +2,41 @@
 #define ENGINEV1_HH
 
 #include "players.hpp"
+#include "pieceSquareTables.hpp"
+#include "nnue.hpp"
 
 class TranspositionTable {
 public:
     struct transTableEntry {
         uint64_t zobristHash;
-        uint32_t score; //Maybe uint16_t
+        int32_t score; //Signed, the scores can be negative
+        uint16_t bestMove; //The best move found in this board, encoded, 0 if there is none
         uint8_t depth;
-        uint8_t nodeType;
+        uint8_t nodeType : 2;
+        uint8_t generation : 6; //The search that stored the entry
     };
 
     static constexpr uint8_t NT_EXACT = 0;
     static constexpr uint8_t NT_LOWERBOUND = 1;
     static constexpr uint8_t NT_UPPERBOUND = 2;
-    static constexpr uint8_t NT_QUIESCENCE = 3;
+
+    //  Mate scores: a mate in ply plies from the root is scored MATE - ply, and -MATE + ply for the mated player. Any score beyond MATE_THRESHOLD is a mate
+    static constexpr int MATE = 900000;
+    static constexpr int MATE_THRESHOLD = MATE - 1000;
 
     void clear() {
         memset(transpositionTableBuffer, 0, sizeof(transpositionTableBuffer));
+        generation = 0;
+    }
+
+    //  Starts a new search. The table is kept between searches, but the scores of the previous ones depend on the moves played before them: a repetition draw found then may not be one now. So only their best moves are used
+    void newSearch() {
+        generation = (generation + 1) & GENERATION_MASK;
+    }
+
+    //  True if the entry has been stored by the current search, otherwise its score can't be used, only its best move
+    bool isCurrent(const transTableEntry* entry) const {
+        return entry->generation == generation;
     }
 
 
@@ -26,28 +44,240 @@ public:
         return transpositionTableBuffer[zobristHash % TRANSPOSITION_TABLE_MASK].zobristHash == zobristHash;
     }
 
-    void insert(uint64_t zobristHash, uint32_t score, uint8_t depth, uint8_t node) {
-        transpositionTableBuffer[zobristHash % TRANSPOSITION_TABLE_MASK] = {zobristHash, score, depth, node};
+    //  If no best move is given, the one already stored for the same board is kept. Ply is the distance from the root to the board, mate scores are stored relative to the board instead of the root, so they are still valid when the board is reached through another path
+    void insert(uint64_t zobristHash, int32_t score, uint8_t depth, uint8_t node, int ply, uint16_t bestMove = 0) {
+        transTableEntry& entry = transpositionTableBuffer[zobristHash % TRANSPOSITION_TABLE_MASK];
+        if (bestMove == 0 && entry.zobristHash == zobristHash) bestMove = entry.bestMove;
+        if (score >= MATE_THRESHOLD) score += ply;
+        else if (score <= -MATE_THRESHOLD) score -= ply;
+        entry = {zobristHash, score, bestMove, depth, node, generation};
     }
 
     const transTableEntry* getEntry(uint64_t zobristHash) {
         return &transpositionTableBuffer[zobristHash % TRANSPOSITION_TABLE_MASK];
     }
 
+    //  Returns the score of the entry relative to the root, ply being the distance from the root to the board
+    static int getScore(const transTableEntry* entry, int ply) {
+        if (entry->score >= MATE_THRESHOLD) return entry->score - ply;
+        if (entry->score <= -MATE_THRESHOLD) return entry->score + ply;
+        return entry->score;
+    }
+
 private:
     static constexpr int TRANSPOSITION_TABLE_SIZE = 1 << 20;
     static constexpr int TRANSPOSITION_TABLE_MASK = TRANSPOSITION_TABLE_SIZE - 1;
+    static constexpr uint8_t GENERATION_MASK = 63; //The generations wrap around, an entry 64 searches old is taken as current
     transTableEntry transpositionTableBuffer[TRANSPOSITION_TABLE_SIZE];
+    uint8_t generation = 0;
+};
+
+//  Caches the evaluation of the pawn structure, indexed by the pawn hash of the board. The pawns only change in a few moves, so most of the boards of a search share an entry with many others.
+//      Pawn Hash Table: [https://www.chessprogramming.org/Pawn_Hash_Table]
+class PawnHashTable {
+public:
+    struct pawnTableEntry {
+        uint64_t pawnHash;
+        PackedScore score; //The pawn structure score, from white's perspective
+    };
+
+    void clear() {
+        memset(pawnTableBuffer, 0, sizeof(pawnTableBuffer));
+    }
+
+    //  Returns the entry where the pawn hash is stored, it may belong to another pawn structure
+    pawnTableEntry* getEntry(uint64_t pawnHash) {
+        return &pawnTableBuffer[pawnHash & PAWN_TABLE_MASK];
+    }
+
+private:
+    static constexpr int PAWN_TABLE_SIZE = 1 << 16;
+    static constexpr int PAWN_TABLE_MASK = PAWN_TABLE_SIZE - 1;
+    pawnTableEntry pawnTableBuffer[PAWN_TABLE_SIZE];
+};
+
+//  Caches the static evaluation of the boards, indexed by their zobrist hash. Each entry is a single 64-bit word with the upper half of the hash and the evaluation, so it's read and written atomically without locks, and a half written entry can't be taken for a valid one.
+//      Evaluation Hash Table: [https://www.chessprogramming.org/Evaluation_Hash_Table]
+class EvalCache {
+public:
+    void clear() {
+        for (std::atomic<uint64_t>& entry : evalCacheBuffer) entry.store(0, std::memory_order_relaxed);
+    }
+
+    //  Returns true if the evaluation of the board is stored, setting it to eval
+    bool probe(uint64_t zobristHash, int& eval) const {
+        uint64_t entry = evalCacheBuffer[zobristHash & EVAL_CACHE_MASK].load(std::memory_order_relaxed);
+        if ((entry & KEY_MASK) != (zobristHash & KEY_MASK)) return false;
+        eval = int32_t(uint32_t(entry));
+        return true;
+    }
+
+    void store(uint64_t zobristHash, int eval) {
+        evalCacheBuffer[zobristHash & EVAL_CACHE_MASK].store((zobristHash & KEY_MASK) | uint32_t(eval), std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int EVAL_CACHE_SIZE = 1 << 16; //Number of entries, it has to be a power of two
+    static constexpr uint64_t EVAL_CACHE_MASK = EVAL_CACHE_SIZE - 1;
+    static constexpr uint64_t KEY_MASK = 0xffffffff00000000;
+    std::atomic<uint64_t> evalCacheBuffer[EVAL_CACHE_SIZE];
+};
+
+//  Caches the information that only depends on the material of the board, indexed by the material key: the imbalance score, the endgame recognised, if any, and the scale factors of the endgame score.
+//      Material Hash Table: [https://www.chessprogramming.org/Material_Hash_Table]
+class MaterialTable {
+public:
+    //  The endgames with their own evaluation, which replaces the usual one, and the ones where the usual evaluation is kept but its endgame score is scaled down
+    //      Endgame: [https://www.chessprogramming.org/Endgame]
+    enum EndgameType : uint8_t {
+        NO_ENDGAME,
+        KXK_ENDGAME, //A lone king against a queen, a rook or two bishops, with any other pieces and pawns
+        KBNK_ENDGAME, //A lone king against a bishop and a knight
+        KPK_ENDGAME, //A lone king against a pawn
+        BISHOPS_ENDGAME //A bishop and pawns each, scaled if the bishops are of opposite colors
+    };
+
+    //  The scale factor that keeps the endgame score, 0 makes it a draw
+    static constexpr int SCALE_FACTOR_NORMAL = 64;
+
+    struct materialTableEntry {
+        uint64_t materialKey;
+        PackedScore imbalance; //The material imbalance score, from white's perspective
+        EndgameType endgame;
+        PieceColor strongSide; //The color with the extra material in the recognised endgame
+        uint8_t scaleFactor[2]; //The scale factor of the endgame score when each color is ahead
+    };
+
+    void clear() {
+        memset(materialTableBuffer, 0, sizeof(materialTableBuffer));
+    }
+
+    //  Returns the entry where the material key is stored, it may belong to another material
+    materialTableEntry* getEntry(uint64_t materialKey) {
+        return &materialTableBuffer[(materialKey * 0x9e3779b97f4a7c15) >> (64 - MATERIAL_TABLE_BITS)];
+    }
+
+private:
+    static constexpr int MATERIAL_TABLE_BITS = 13;
+    materialTableEntry materialTableBuffer[1 << MATERIAL_TABLE_BITS];
+};
+
+class TimeManager {
+public:
+    //  The engine will use a fixed time span for each move.
+    void setMoveTime(std::chrono::milliseconds moveTime);
+
+    //  The engine will budget its time from the remaining time in its clock and the increment it gets after each move.
+    void setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment);
+
+    //  Starts the timer of a new search and calculates its time limits. With only one legal move there is no need to think.
+    void start(int legalMovesCount);
+
+    //  Called after each completed iteration. The soft limit is adapted: if the best move is stable it's reduced, if the best move keeps changing or the score drops, it's extended up to the hard limit.
+    void iterationFinished(const PieceMove& bestMove, int score);
+
+    //  Returns true if no new iteration should be started.
+    bool softLimitReached() const;
+
+    //  Returns true if the search has to be stopped now.
+    bool hardLimitReached() const;
+
+    //  Returns the time elapsed since the search started.
+    std::chrono::milliseconds elapsed() const;
+
+    //  Returns the time the search was expected to use, and the maximum it could use.
+    std::chrono::milliseconds getOptimumTime() const;
+    std::chrono::milliseconds getMaximumTime() const;
+
+private:
+    bool useClock = false; //True if the time is budgeted from the clock, false if moveTime is used
+    std::chrono::milliseconds moveTime{0};
+    std::chrono::milliseconds clockRemaining{0};
+    std::chrono::milliseconds clockIncrement{0};
+
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::milliseconds optimumTime{0}; //The time expected to be used in a normal board
+    std::chrono::milliseconds maximumTime{0}; //Hard limit, never exceeded
+    std::chrono::milliseconds softLimit{0}; //After it, no new iteration is started
+
+    //  Information of the previous iterations
+    int iterations;
+    PieceMove lastBestMove;
+    int lastScore;
+    int stableIterations; //Number of consecutive iterations with the same best move
+    double bestMoveInstability; //Increased each time the best move changes, decays on every iteration
+
+    //  With a fixed move time, the whole span is the hard limit and no new iteration is started after SOFT_TIME_RATIO of it, since it would probably not finish
+    static constexpr double SOFT_TIME_RATIO = 0.5;
+
+    //  With a clock, the budget is the remaining time divided by MOVES_TO_GO plus INCREMENT_USAGE of the increment. It can be extended up to MAX_EXTENSION times, but never more than MAX_REMAINING_USAGE of the remaining time. MOVE_OVERHEAD is kept for the communication delays
+    static constexpr int MOVES_TO_GO = 30;
+    static constexpr double INCREMENT_USAGE = 0.75;
+    static constexpr double MAX_EXTENSION = 4.0;
+    static constexpr double MAX_REMAINING_USAGE = 0.25;
+    static constexpr std::chrono::milliseconds MOVE_OVERHEAD = std::chrono::milliseconds(30);
+    static constexpr std::chrono::milliseconds MIN_MOVE_TIME = std::chrono::milliseconds(10);
+
+    //  Adaptation of the soft limit. After STABLE_ITERATIONS with the same best move, once STABILITY_MIN_ITERATIONS have been searched, the soft limit is multiplied by STABLE_FACTOR. Each best move change adds BEST_MOVE_CHANGE_FACTOR, a score drop of SCORE_DROP_SCALE doubles it
+    static constexpr int STABILITY_MIN_ITERATIONS = 6;
+    static constexpr int STABLE_ITERATIONS = 4;
+    static constexpr double STABLE_FACTOR = 0.5;
+    static constexpr double BEST_MOVE_CHANGE_FACTOR = 0.5;
+    static constexpr int SCORE_DROP_MARGIN = 20;
+    static constexpr int SCORE_DROP_SCALE = 150;
+};
+
+//  The search parameters that are tuned by playing games, see tools/spsa. The defaults are the values the engine plays with, the techniques that use them are described in EngineV1
+struct SearchParameters {
+    static constexpr int RAZORING_MAX_DEPTH = 3;
+    static constexpr int FUTILITY_MAX_DEPTH = 3;
+
+    int aspirationWindow = 50; //The first window around the previous iteration score
+    int nullMoveReduction = 2; //The depth reduction of the null move, plus one more every nullMoveDepthDivisor
+    int nullMoveDepthDivisor = 6;
+    int rfpMargin = 120; //The reverse futility pruning margin per depth
+    int razoringMargin[RAZORING_MAX_DEPTH + 1] = {0, 300, 450, 600}; //Indexed by depth
+    int futilityMargin[FUTILITY_MAX_DEPTH + 1] = {0, 150, 300, 500}; //Indexed by depth
+    double lmrBase = 0.75; //The late move reductions are lmrBase + log(depth) * log(moveNumber) / lmrDivisor
+    double lmrDivisor = 2.25;
+    int lmrHistoryDivisor = 8192; //Each lmrHistoryDivisor of history score changes the late move reduction by one
+    int deltaMargin = 200; //Delta pruning: a capture is not searched in the quiescence search if the stand pat plus the captured piece and deltaMargin can't reach alpha
 };
 
 class EngineV1 : public Player {
 public:
-    EngineV1(std::shared_ptr<Board> myBoard, std::chrono::milliseconds timeSpan);
-    ~EngineV1() override {}
+    //  A line found by the search: its first move, its evaluation for the player to move and the principal variation starting with that move
+    struct PVLine {
+        PieceMove move;
+        int eval;
+        std::vector<PieceMove> pv;
+    };
+
+    //  If ponder is true, the engine will keep searching during the opponent's turn. With multiPV greater than 1, the engine searches the best multiPV moves, each one with its own line. If a loaded network is given, it evaluates the boards instead of the hand-written evaluation
+    EngineV1(std::shared_ptr<Board> myBoard, std::chrono::milliseconds timeSpan, bool ponder, int multiPV = 1, std::shared_ptr<const NNUE> network = nullptr);
+    ~EngineV1() override;
 
     bool canMove() override;
     PieceMove getMove() override;
 
+    //  Returns the lines found in the last search, from best to worst. There are as many as the multiPV given, unless there are fewer legal moves or the search was stopped before finishing its first iteration. All of them come from the same depth, and the first one is the move played
+    const std::vector<PVLine>& getPVLines() const;
+
+    //  Sets the remaining time of the engine's clock and its increment per move, the time for each move will be budgeted from them instead of using a fixed time span
+    void setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment) override;
+
+    //  Returns the static evaluation of the game board, in centipawns from the perspective of the player to move, without searching. Used by the tuner and the tests
+    int staticEvaluation();
+
+    //  Returns true if the static evaluation of the game board is the blend of its midgame and endgame scores by the phase: there is no network, and its material has neither its own endgame evaluation nor a scale factor. Used by the tuner, which only fits those positions
+    bool taperedStaticEvaluation();
+
+    //  Sets the parameters of the search, used by the SPSA tuner to play with different values
+    void setSearchParameters(const SearchParameters& parameters);
+
+    //  If verbose is false, the engine doesn't print the information of its searches. It's true by default
+    void setVerbose(bool verbose);
+
 private:
     struct MoveEval {
         PieceMove move;
@@ -61,126 +291,331 @@ private:
         }
     };
 
+    //  A move and the score given by the move ordering, the higher the score the sooner it will be searched
+    struct ScoredMove {
+        PieceMove move;
+        int score;
+    };
+
+    //  The type of a node of the search, known before searching it. The principal variation nodes are searched with an open window and can change the principal variation, the rest are searched with a null window and are expected to fail. The root node is searched by firstSearch
+    //      Node Types: [https://www.chessprogramming.org/Node_Types]
+    enum SearchNodeType : uint8_t {
+        PV_NODE,
+        NON_PV_NODE
+    };
+
+    //  The outcome of an iterative deepening search
+    struct SearchResult {
+        MoveEval bestMoveEval;
+        int depth; //The depth reached, the last iteration may be incomplete
+        PieceColor mateColor; //The color of the player that can force a checkmate, NONE_COLOR if no checkmate has been found
+        std::vector<PVLine> lines; //The lines found, the first one is the principal variation, starting with the best move
+    };
+
+    //  The engine searches in its own copy of the game board, so it can keep searching while the game board is used by the opponent
+    std::shared_ptr<Board> gameBoard;
+
     TranspositionTable transpositionTable;
+    PawnHashTable pawnHashTable;
+    EvalCache evalCache;
+    MaterialTable materialTable;
 
     //  Time related variables, the more time the engine has, the better the move it will make
-    //      The atomic variables are needed because they will be accessed by different threads
-    std::chrono::milliseconds moveDelay; //The time the engine has to make a move
-    std::atomic<bool> searchTimeExceeded; //True if the time has exceeded
-    std::atomic<bool> stopTimer; //True if the timer has to stop
+    //      The time is checked inside the search every TIME_CHECK_INTERVAL boards
+    TimeManager timeManager; //Decides how much time each move will take
+    bool searchTimeExceeded; //True if the hard limit has been reached
+
+    //  Pondering: after making its move, the engine searches the board after the expected reply in another thread, with no time limit. If the opponent makes that move, the search goes on with the real time budget, otherwise it's cancelled. In both cases the transposition table is kept, the next searches use the best moves stored by the previous ones.
+    //      Pondering: [https://www.chessprogramming.org/Pondering]
+    bool ponderEnabled; //True if the engine ponders
+    std::thread ponderThread;
+    std::atomic<bool> pondering; //True while the search has no time limit, it's set to false on a ponder hit
+    std::atomic<bool> ponderStop; //Set to cancel the ponder search on a ponder miss
+    uint64_t ponderHash; //The zobrist hash of the board being pondered
+    SearchResult ponderResult; //The result of the ponder search, only read after joining the thread
+
+    //  Multi-PV: each iteration searches the root multiPV times, every time excluding the moves of the lines already found. The transposition table is shared by all of them.
+    //      Multi-PV: [https://www.chessprogramming.org/Principal_Variation#Multiple_PVs]
+    int multiPV; //The number of lines searched
+    std::vector<PVLine> pvLines; //The lines found in the last search
+
+    SearchParameters searchParameters; //The margins, windows and reductions of the search
+    bool verbose; //True if the information of the searches is printed
+
+    //  Neural network evaluation: the accumulators of the boards of the current line are kept in a stack, the one of the root is computed from scratch and each move updates the next one from the previous with the pieces it changed. A null move only copies it. Without a network, the hand-written evaluation is used
+    std::shared_ptr<const NNUE> network;
 
     //  The purpose of these variables is to keep information of a search.
     int numBoards; //Number of boards evaluated in the search
     int transpositionHits; //Number of transposition table hits
+    int pawnHashProbes; //Number of pawn hash table probes
+    int pawnHashHits; //Number of pawn hash table hits
+    int evalCacheProbes; //Number of evaluation cache probes
+    int evalCacheHits; //Number of evaluation cache hits
+    int lazyEvalCutoffs; //Number of evaluations that skipped the expensive stage
+
+    //  Searches the board with iterative deepening until the time runs out or the search is stopped. The time manager has to be started before, unless pondering.
+    SearchResult iterativeDeepening();
+
+    //  Sets the board after the engine's best move and the expected reply, and starts pondering it in ponderThread. They are taken from the principal variation, if it only has the best move the reply is taken from the transposition table. Nothing is done if there is no expected reply.
+    void startPondering(const std::vector<PieceMove>& pv);
 
-    //  For each depth in iterative deepening, it will search for the best move. Returns the best move and its evaluation. This is the first search for the different depths. This function will call the search function.
+    //  Cancels the ponder search, if any, and waits for it to finish.
+    void stopPondering();
+
+    //  For each depth in iterative deepening, it will search for the best move. Leaves the evaluated moves in rootEvaluatedMoves, the first one being searched with the (alpha, beta) window and the rest with a null window. The search stops as soon as a move fails high. This is the first search for the different depths. This function will call the search function.
     //      Iterative Deepening: [https://en.wikipedia.org/wiki/Iterative_deepening_depth-first_search]
-    std::vector<EngineV1::MoveEval> firstSearch(const std::vector<PieceMove>& orderedMoves, int depth);
+    void firstSearch(const std::vector<PieceMove>& orderedMoves, int depth, int alpha, int beta);
 
     //  Recursive function that searches for the best move. Depth is the current depth of the search, alfa and beta are the bounds of the search.
-    //  Negamax algorithm with alpha-beta pruning. For more information, visit:
+    //  Negamax algorithm with fail-soft alpha-beta pruning and Principal Variation Search. For more information, visit:
     //      - Negamax: [https://www.chessprogramming.org/Negamax]
     //      - Alpha Beta Pruning: [https://www.chessprogramming.org/Alpha-Beta]
-    int search(int depth, int alfa, int beta);
+    //      - Principal Variation Search: [https://www.chessprogramming.org/Principal_Variation_Search]
+    //  It's compiled for each node type, so the non PV nodes don't check the conditions of the PV nodes, nor keep the principal variation.
+    template <SearchNodeType nodeType>
+    int search(int depth, int ply, int alfa, int beta);
 
     //  Searches for a quiet position. A quiet position is a position where no captures are possible. Returns the value of the position.
-    int quiescenceSearch(int alfa, int beta);
+    //  Fail-soft, the static evaluation is used as a lower bound (stand pat) unless in check, where all the evasions are searched. The captures are ordered by MVV-LVA, and the ones that lose material or can't raise the score above alpha are pruned.
+    //      Quiescence Search: [https://www.chessprogramming.org/Quiescence_Search]
+    int quiescenceSearch(int ply, int alfa, int beta);
+
+    //  The moves are made and undone in the search through these functions, which also keep the network accumulators. When built with ENGINE_ALLOCATION_CHECK, the memory they allocate is counted apart: the board keeps its legal moves and its log in containers, but the rest of the search must not allocate memory, which is asserted in every board searched and at the root. So the check only covers the engine's own allocations, not the board's.
+    void makeMove(PieceMove& move);
+    void undoMove();
+    void makeNullMove();
+    void undoNullMove();
+
+    //  The legal moves of the board, which after a null move are calculated when first asked for. Their allocations are counted as the board's
+    const std::set<PieceMove>& getLegalMoves();
+
+    //  Scores the moves and stores them in the buffer, returns the number of moves. The order is: hash move, promotions, captures (MVV-LVA), killer moves, counter move and the rest of quiet moves by their history. Helps the alpha-beta pruning.
+    //      MVV-LVA: [https://www.chessprogramming.org/MVV-LVA]
+    int orderMoves(const std::set<PieceMove>& moves, ScoredMove* buffer, int ply, const PieceMove& hashMove);
+
+    //  Scores the moves searched by the quiescence search and stores them in the buffer, returns the number of moves. Those are the captures and the queen promotions, or all the moves if in check. The hash move goes first, then the promotions and the captures (MVV-LVA).
+    int orderQuiescenceMoves(ScoredMove* buffer, int ply, const PieceMove& hashMove, bool inCheck);
+
+    //  Returns the move ordering score of a capture, by MVV-LVA
+    int captureScore(const PieceMove& move);
+
+    //  Selection sort step: swaps the best scored move from the position index onwards into the index position, and returns it.
+    const PieceMove& pickNextMove(ScoredMove* buffer, int moveCount, int index);
+
+    //  Updates the killer moves, history and counter move tables after the quiet move produced a beta cutoff. The quiet moves searched before it in the ply are penalized.
+    void updateQuietHeuristics(const PieceMove& move, int ply, int depth);
+
+    //  Adds the bonus to the history entry, the gravity keeps the values inside [-HISTORY_MAX, HISTORY_MAX]
+    void updateHistory(int& entry, int bonus);
+
+    //  Clears the killer moves and ages the history for a new search
+    void resetMoveOrdering();
+
+    //  Returns true if the score means that a checkmate has been found
+    static bool isMateScore(int score);
+
+    //  Returns the number of moves to the checkmate of a mate score, from the root
+    static int mateInMoves(int score);
+
+    //  Returns the score as a string, mates are shown as M<moves> if the player to move mates, or -M<moves> if it gets mated
+    static std::string scoreToString(int score);
+
+    //  Fills the lmrReductions table
+    void initLateMoveReductions();
 
-    //  Orders the moves in the list from best to worst. The ordering is done by the evaluation of the move. Helps the alpha-beta pruning.
-    void orderMoves(const std::set<PieceMove>& moves, std::list<PieceMove>& orderedMoves);
+    //  Returns how much the depth of a quiet late move has to be reduced
+    int lateMoveReduction(int depth, int moveNumber, int history, bool pvNode, bool givesCheck, bool isRefutation);
 
-    //  Evaluates the board. Returns the value of the board from white's perspective. Heuristic function.
-    int evaluate();
+    //  Encodes a move in 16 bits, used to store it in the transposition table: 6 bits for each square and 4 for the promotion
+    static uint16_t encodeMove(const PieceMove& move);
+    static PieceMove decodeMove(uint16_t code);
 
-    //  Returns a value between 0 and 1 that represents the current endgame phase of the player with the color myColor. The closer to 1, the closer to the endgame.
-    float currentEndGamePhaseWeight(PieceColor myColor);
+    //  Evaluates the board. Returns the value of the board from the perspective of the player to move. Heuristic function.
+    //  The evaluations are kept in the evaluation cache, calculateEvaluation is only called if the board isn't there.
+    //  Lazy evaluation: with the hand-written evaluation, if the cheap stage, material and piece-square tables, is beyond the (alpha, beta) window by LAZY_EVAL_MARGIN, the expensive stage is skipped and the cheap evaluation moved LAZY_EVAL_MARGIN towards the window is returned as a bound. It isn't cached.
+    //      Lazy Evaluation: [https://www.chessprogramming.org/Lazy_Evaluation]
+    int evaluate(int alpha = -INF, int beta = INF);
 
-    //  Returns the material value of the board from the perspective of the player with the color myColor
-    int countMaterial(PieceColor myColor);
+    //  Evaluates the board without the cache. If the engine has a network, the board is evaluated by it. Otherwise, tapered evaluation: the evaluation terms are added as packed midgame and endgame scores, which are blended once by the game phase.
+    //      Tapered Eval: [https://www.chessprogramming.org/Tapered_Eval]
+    int calculateEvaluation();
 
-    //  Returns the positional value of the board from white's perspective
-    int countPositionalValue(PieceColor myColor, float myEndGamePhase);
+    //  Blends the midgame and endgame scores of a score from white's perspective by the game phase, returns it from the perspective of the player to move
+    int taperedEvaluation(PackedScore score);
 
-    void iniTimer(std::chrono::milliseconds timeSpan);
+    //  The expensive stage of the hand-written evaluation, the terms that aren't kept by the board. Returns their score from white's perspective
+    PackedScore positionalScore();
+
+    //  Returns the entry of the material of the board, it's calculated if it isn't in the material table
+    const MaterialTable::materialTableEntry* probeMaterial();
+
+    //  Fills the entry of the material key from the number of pieces of each type
+    static void calculateMaterial(uint64_t materialKey, MaterialTable::materialTableEntry& entry);
+
+    //  Evaluates the board with the evaluation of its recognised endgame, from the perspective of the player to move. Returns false if there is none for the board, then the usual evaluation is used
+    bool evaluateEndgame(const MaterialTable::materialTableEntry& material, int& evaluation);
+
+    //  Returns the scale factor of the endgame score when the color is ahead, SCALE_FACTOR_NORMAL if it's not scaled
+    int endgameScaleFactor(const MaterialTable::materialTableEntry& material, PieceColor strongSide);
+
+    //  Distances between squares, given by the index of their bits: the number of king moves from one to the other, and from the square to the nearest edge
+    static int squareDistance(int square1, int square2);
+    static int edgeDistance(int square);
+
+    //  Returns the pawn structure score from white's perspective. The structure is taken from the pawn hash table, or calculated and stored there. The pawn shields depend on the kings too, so they are added apart
+    PackedScore evaluatePawns();
+
+    //  Returns the score of the passed, isolated, doubled and backward pawns of both players, from white's perspective
+    //      Pawn Structure: [https://www.chessprogramming.org/Pawn_Structure]
+    static PackedScore pawnStructureScore(uint64_t whitePawns, uint64_t blackPawns);
+
+    //  Returns the score of the pawns of the color sheltering its king, in the two ranks in front of it
+    //      King Safety, Pawn Shield: [https://www.chessprogramming.org/King_Safety#Pawn_Shield]
+    static PackedScore pawnShieldScore(uint64_t king, uint64_t pawns, PieceColor col);
+
+    //  Returns the score of the mobility of the pieces, their attacks to the opponent's king zone and the safe checks they can give, from white's perspective. The attacks of each piece are taken from the attack tables and counted with popcount, no moves are generated
+    //      Mobility: [https://www.chessprogramming.org/Mobility]
+    //      King Safety: [https://www.chessprogramming.org/King_Safety]
+    PackedScore pieceActivityScore();
+
+    //  Stores the move as the first one of the principal variation of the ply, followed by the principal variation of the next ply
+    void updatePV(int ply, const PieceMove& move);
+
+    //  Returns the principal variation found from the root
+    std::vector<PieceMove> getRootPV() const;
+
+    //  Returns the moves of the principal variation as a string
+    static std::string pvToString(const std::vector<PieceMove>& pv);
+
+    //  Prints the information of a finished search: its depth, evaluation, statistics, time used and principal variation
+    void printSearchInfo(const SearchResult& result);
+
+    //  Sets searchTimeExceeded if the hard limit has been reached, or if the ponder search has been cancelled. It is called every TIME_CHECK_INTERVAL boards
+    void checkTime();
 
     
     static constexpr int MAX_DEPTH = 50;
+    static constexpr int MAX_PLY = 128;
+    static constexpr int MAX_MOVES = 256;
     static constexpr int INF = 1000000;
+    static constexpr int MATE = TranspositionTable::MATE;
+
+    //  Time control: the clock is checked every TIME_CHECK_INTERVAL boards, it has to be a power of two
+    static constexpr int TIME_CHECK_INTERVAL = 1024;
+
+    //  Aspiration windows: the root is searched with a window of aspirationWindow around the previous iteration score. Each time it fails, the window is widened by half of its size, when it gets bigger than ASPIRATION_MAX_WINDOW a full window is used.
+    //      Aspiration Windows: [https://www.chessprogramming.org/Aspiration_Windows]
+    static constexpr int ASPIRATION_MAX_WINDOW = 1000;
+
+    //  Null move pruning: if passing the turn at a reduced depth still fails high, the board is pruned. Only from NULL_MOVE_MIN_DEPTH, the depth is reduced by nullMoveReduction plus one more every nullMoveDepthDivisor.
+    //      Null Move Pruning: [https://www.chessprogramming.org/Null_Move_Pruning]
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3;
 
+    //  Pruning near the leaves, using the static evaluation of the board. The margins are indexed by depth, they are not used in check, in the principal variation, nor when the window is a mate score.
+    //      Reverse Futility Pruning: if the static evaluation minus rfpMargin per depth is still above beta, the board is pruned. [https://www.chessprogramming.org/Reverse_Futility_Pruning]
+    //      Razoring: if the static evaluation plus the margin is below alpha, the board is only searched by the quiescence search. [https://www.chessprogramming.org/Razoring]
+    //      Futility Pruning: if the static evaluation plus the margin is below alpha, the quiet moves that don't give check are not searched. [https://www.chessprogramming.org/Futility_Pruning]
+    static constexpr int RFP_MAX_DEPTH = 3;
+    static constexpr int RAZORING_MAX_DEPTH = SearchParameters::RAZORING_MAX_DEPTH;
+    static constexpr int FUTILITY_MAX_DEPTH = SearchParameters::FUTILITY_MAX_DEPTH;
+
+    //  Late Move Reductions: quiet moves searched late are searched with a reduced depth, and searched again at full depth if they improve alpha. The reduction is taken from a table indexed by depth and move number: lmrBase + log(depth) * log(moveNumber) / lmrDivisor
+    //      Late Move Reductions: [https://www.chessprogramming.org/Late_Move_Reductions]
+    static constexpr int LMR_MIN_DEPTH = 3;
+    static constexpr int LMR_MIN_MOVE_NUMBER = 3; //The first moves are never reduced
+    static constexpr int LMR_TABLE_SIZE = 64;
+
+    //  Move ordering scores, by groups
+    static constexpr int HASH_MOVE_SCORE = 1 << 30;
+    static constexpr int PROMOTION_SCORE = 1 << 28;
+    static constexpr int CAPTURE_SCORE = 1 << 27;
+    static constexpr int KILLER_SCORE = 1 << 26;
+    static constexpr int COUNTER_MOVE_SCORE = 1 << 25;
+    static constexpr int TARGETED_PENALTY = 1 << 16; //Quiet moves to squares targeted by the opponent are searched last
+    static constexpr int HISTORY_MAX = 1 << 14;
+    static constexpr int PIECE_ORDER_RANK[13] = {1, 3, 2, 4, 5, 6, 1, 3, 2, 4, 5, 6, 0}; //Indexed by PieceType, used by MVV-LVA
+
+    //  Move ordering heuristics, they are learned during the search. For more information, visit:
+    //      - Killer Heuristic: [https://www.chessprogramming.org/Killer_Heuristic]
+    //      - History Heuristic: [https://www.chessprogramming.org/History_Heuristic]
+    //      - Countermove Heuristic: [https://www.chessprogramming.org/Countermove_Heuristic]
+    int historyTable[2][64][64]; //For each color, from square and to square, how good the quiet move has been in the search
+    PieceMove counterMoves[12][64]; //For each piece type and to square of the previous move, the quiet move that refuted it
+
+    int lmrReductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE]; //The base reduction, indexed by depth and move number
+
+    //  The information of the search for each ply, preallocated in searchStack so that the search doesn't allocate memory. Each node only uses its own entry and the ones of its parent and children
+    struct SearchStack {
+        ScoredMove moves[MAX_MOVES]; //The moves of the board, scored by the move ordering
+        PieceMove searchedQuiets[MAX_MOVES]; //The quiet moves already searched, they are penalized in the history if another quiet move produces a cutoff
+        int searchedQuietsCount;
+        PieceMove killers[2]; //Two quiet moves that produced a beta cutoff in this ply
+        PieceMove playedMove; //The move made in this ply of the current line, invalidMove for a null move
+        PieceType playedPiece; //The piece moved in this ply of the current line, NONE for a null move
+        PieceMove pv[MAX_PLY]; //The principal variation from this ply on, see pvLength
+        int pvLength;
+        bool followingPV; //True if the moves played up to this ply are the ones of the previous principal variation
+    };
+
+    //  The search stack, indexed by ply. Only one search runs at a time in each engine, the ponder search included, so a single stack is needed.
+    //  Principal variation, the line expected to be played. It's collected in a triangular table: the pv of each ply has the best line found from that ply on.
+    //      Triangular PV-Table: [https://www.chessprogramming.org/Triangular_PV-Table]
+    SearchStack searchStack[MAX_PLY];
+    PieceMove previousPV[MAX_PLY]; //The principal variation of the previous iteration, searched first in the next one
+    int previousPVLength;
+    std::vector<MoveEval> rootEvaluatedMoves; //The moves evaluated by the last root search, its capacity is reserved for MAX_MOVES so the root doesn't allocate memory either
+
+    NNUE::Accumulator accumulatorStack[MAX_PLY + 1]; //The network accumulators of the current line, only used with a network
+    int accumulatorIndex; //The accumulator of the current board
+
+    //  The values of the pieces used by the search, the evaluation uses the ones of PieceSquareTables
     static constexpr int PAWN_VALUE = 100;
     static constexpr int KNIGHT_VALUE = 320;
     static constexpr int BISHOP_VALUE = 330;
     static constexpr int ROOK_VALUE = 500;
     static constexpr int QUEEN_VALUE = 900;
 
-    //  The start of the endgame is when the material is less than endgameMaterialStart
-    static constexpr int endgameMaterialStart = 1650; // 1650 = 2*ROOK + KINGHT + BISHOP
-
-    const int pawnEvals[8][8] = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        50, 50, 50, 50, 50, 50, 50, 50,
-        10, 10, 20, 30, 30, 20, 10, 10,
-        5,  5, 10, 25, 25, 10,  5,  5,
-        0,  0,  0, 20, 20,  0,  0,  0,
-        5, -5,-10,  0,  0,-10, -5,  5,
-        5, 10, 10,-20,-20, 10, 10,  5,
-        0,  0,  0,  0,  0,  0,  0,  0};
-    const int knightEvals[8][8] = {
-        -50,-40,-30,-30,-30,-30,-40,-50,
-        -40,-20,  0,  0,  0,  0,-20,-40,
-        -30,  0, 10, 15, 15, 10,  0,-30,
-        -30,  5, 15, 20, 20, 15,  5,-30,
-        -30,  0, 15, 20, 20, 15,  0,-30,
-        -30,  5, 10, 15, 15, 10,  5,-30,
-        -40,-20,  0,  5,  5,  0,-20,-40,
-        -50,-40,-30,-30,-30,-30,-40,-50};
-    const int bishopEvals[8][8] = {
-        -20,-10,-10,-10,-10,-10,-10,-20,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -10,  0,  5, 10, 10,  5,  0,-10,
-        -10,  5,  5, 10, 10,  5,  5,-10,
-        -10,  0, 10, 10, 10, 10,  0,-10,
-        -10, 10, 10, 10, 10, 10, 10,-10,
-        -10,  5,  0,  0,  0,  0,  5,-10,
-        -20,-10,-10,-10,-10,-10,-10,-20};
-    const int rookEvals[8][8] = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        5, 10, 10, 10, 10, 10, 10,  5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        0,  0,  0,  5,  5,  0,  0,  0};  
-    const int queenEvals[8][8] = {
-        -20,-10,-10, -5, -5,-10,-10,-20,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -10,  0,  5,  5,  5,  5,  0,-10,
-        -5,  0,  5,  5,  5,  5,  0, -5,
-        0,  0,  5,  5,  5,  5,  0, -5,
-        -10,  5,  5,  5,  5,  5,  0,-10,
-        -10,  0,  5,  0,  0,  0,  0,-10,
-        -20,-10,-10, -5, -5,-10,-10,-20};
-    const int kingEvalsMidGame[8][8] = {
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -20,-30,-30,-40,-40,-30,-30,-20,
-        -10,-20,-20,-20,-20,-20,-20,-10,
-        20, 20,  0,  0,  0,  0, 20, 20,
-        20, 30, 10,  0,  0, 10, 30, 20
-    };
-    const int kingEvalsEndGame[8][8] {
-        -50,-40,-30,-20,-20,-30,-40,-50,
-        -30,-20,-10,  0,  0,-10,-20,-30,
-        -30,-10, 20, 30, 30, 20,-10,-30,
-        -30,-10, 30, 40, 40, 30,-10,-30,
-        -30,-10, 30, 40, 40, 30,-10,-30,
-        -30,-10, 20, 30, 30, 20,-10,-30,
-        -30,-30,  0,  0,  0,  0,-30,-30,
-        -50,-30,-30,-30,-30,-30,-30,-50
-    };          
+    //  The values used by the static exchange evaluation, indexed by PieceType. The king is worth more than all the other pieces together, so it never captures a defended piece
+    static constexpr int KING_SEE_VALUE = 20000;
+    static constexpr int SEE_PIECE_VALUES[12] = {PAWN_VALUE, BISHOP_VALUE, KNIGHT_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_SEE_VALUE,
+                                                 PAWN_VALUE, BISHOP_VALUE, KNIGHT_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_SEE_VALUE};
+
+    //  Material imbalance: the bishop pair bonus, and for each knight and rook the adjustment for each own pawn above IMBALANCE_PAWNS, the knights being better with more pawns and the rooks with fewer
+    //      Material, Imbalance: [https://www.chessprogramming.org/Material#Imbalance]
+    static constexpr PackedScore BISHOP_PAIR_BONUS = makeScore(30, 50);
+    static constexpr PackedScore KNIGHT_PAWN_ADJUSTMENT = makeScore(3, 3);
+    static constexpr PackedScore ROOK_PAWN_ADJUSTMENT = makeScore(-6, -6);
+    static constexpr int IMBALANCE_PAWNS = 5;
+
+    //  Recognised endgames: a won endgame gets KNOWN_WIN_BONUS over its material. The losing king is pushed to the edge, or to a corner of the color of the bishop in KBNK, and the winning king is brought close to it. The opposite colored bishops are drawish, their endgame score is scaled by OPPOSITE_BISHOPS_SCALE_FACTOR
+    static constexpr int KNOWN_WIN_BONUS = 10000;
+    static constexpr int PUSH_TO_EDGE_BONUS = 20;
+    static constexpr int PUSH_TO_CORNER_BONUS = 20;
+    static constexpr int PUSH_CLOSE_BONUS = 10;
+    static constexpr int OPPOSITE_BISHOPS_SCALE_FACTOR = 32;
+
+    //  Lazy evaluation: the most the expensive stage of the evaluation is expected to change the cheap one
+    static constexpr int LAZY_EVAL_MARGIN = 400;
+
+    //  Pawn structure scores, the passed pawn bonus is indexed by the rank of the pawn from its player's side, the first rank being 0. The pawn shield counts the pawns one and two ranks in front of the king, in its file and the adjacent ones
+    static constexpr PackedScore DOUBLED_PAWN_PENALTY = makeScore(-10, -25);
+    static constexpr PackedScore ISOLATED_PAWN_PENALTY = makeScore(-8, -15);
+    static constexpr PackedScore BACKWARD_PAWN_PENALTY = makeScore(-8, -10);
+    static constexpr PackedScore PASSED_PAWN_BONUS[8] = {makeScore(0, 0), makeScore(5, 10), makeScore(5, 15), makeScore(10, 25),
+                                                        makeScore(20, 45), makeScore(35, 75), makeScore(60, 120), makeScore(0, 0)};
+    static constexpr PackedScore PAWN_SHIELD_CLOSE_BONUS = makeScore(12, 0);
+    static constexpr PackedScore PAWN_SHIELD_FAR_BONUS = makeScore(6, 0);
+
+    //  Piece activity scores, indexed by the PieceType of the white pieces. The mobility counts the squares attacked that are neither taken by own pieces nor attacked by opponent pawns. The king zone, the king and the squares around it, is only taken into account with at least KING_ATTACKERS_MIN pieces attacking it. A safe check is a square where a piece can give check and the opponent doesn't attack
+    static constexpr PackedScore MOBILITY_BONUS[6] = {makeScore(0, 0), makeScore(5, 5), makeScore(4, 4), makeScore(2, 4), makeScore(1, 2), makeScore(0, 0)};
+    static constexpr PackedScore KING_ZONE_ATTACK_BONUS[6] = {makeScore(0, 0), makeScore(6, 0), makeScore(6, 0), makeScore(8, 0), makeScore(10, 0), makeScore(0, 0)};
+    static constexpr int KING_ATTACKERS_MIN = 2;
+    static constexpr PackedScore SAFE_CHECK_BONUS[6] = {makeScore(0, 0), makeScore(20, 5), makeScore(30, 5), makeScore(35, 10), makeScore(25, 10), makeScore(0, 0)};
+
+    //  Files of the board bitmaps, the a-file is the most significant bit of each rank
+    static constexpr uint64_t FILE_A = Attacks::FILE_A;
+    static constexpr uint64_t FILE_H = Attacks::FILE_H;
 };
 
 #endif
\ No newline at end of file
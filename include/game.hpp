@@ -2,6 +2,7 @@
 #define GAME_HH
 
 #include "board.hpp"
+#include "chessClock.hpp"
 #include "myApp.hpp"
 #include "players.hpp"
 #include "engine_v1.hpp"
@@ -25,16 +26,25 @@ private:
     static void printWelcome(unsigned int seed);
 
     // Prints the chosen options
-    static void printOptionsChosen(const std::string& whitePlayer, const std::string& blackPlayer, bool displayGUIApp, std::chrono::milliseconds engineTimeSpan, const std::string& FEN);
+    static void printOptionsChosen(const std::string& whitePlayer, const std::string& blackPlayer, bool displayGUIApp, std::chrono::milliseconds engineTimeSpan, bool enginePonder, int engineMultiPV, const std::string& engineNetworkFile, const ChessClock& gameClock, const std::string& FEN);
 
     // Processes the command line arguments
-    static void processCommandLine(int argc, char* argv[], std::string& whitePlayerName, std::string& blackPlayerName, bool& displayGUIApp, std::chrono::milliseconds& engineTimeSpan, std::string& FEN);
+    static void processCommandLine(int argc, char* argv[], std::string& whitePlayerName, std::string& blackPlayerName, bool& displayGUIApp, std::chrono::milliseconds& engineTimeSpan, bool& enginePonder, int& engineMultiPV, std::string& engineNetworkFile, ChessClock& gameClock, std::string& FEN);
+
+    // Parses a time control with the format <seconds>[+<increment seconds>], e.g. 60+0.5, and sets it to the clock
+    static void parseTimeControl(const std::string& timeControl, ChessClock& gameClock);
+
+    // If the player to move can move, gets its move and makes it. When playing with a clock, its time is charged and the player is informed of its remaining time
+    static void playTurn(std::unique_ptr<Player>& player, std::shared_ptr<Board> myBoard, ChessClock& gameClock);
+
+    // Prints the result of a game lost on time by the player with the color col
+    static void printFlagFall(PieceColor col);
 
     // Initializes the board and application
     static void initializeBoardApp(std::shared_ptr<Board>& myBoard, std::shared_ptr<MyApp>& myApp, bool displayGUIApp, const std::string& FEN);
     
     // Loads the players based on provided names
-    static void loadPlayers(std::unique_ptr<Player>& player, const std::string& playerName, std::shared_ptr<MyApp> myApp, std::shared_ptr<Board> myBoard, std::chrono::milliseconds engineTimeSpan);
+    static void loadPlayers(std::unique_ptr<Player>& player, const std::string& playerName, std::shared_ptr<MyApp> myApp, std::shared_ptr<Board> myBoard, std::chrono::milliseconds engineTimeSpan, bool enginePonder, int engineMultiPV, std::shared_ptr<const NNUE> engineNetwork);
 
     static std::atomic<bool> running; //True if the game is running
     static std::atomic<MyApp::eventType> lastEvent; //The last event that happened
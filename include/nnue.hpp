@@ -0,0 +1,58 @@
+#ifndef NNUE_HH
+#define NNUE_HH
+
+#include "utils.hpp"
+#include "board.hpp"
+
+//  Efficiently updatable neural network, used by the engine as an alternative to the hand-written evaluation.
+//  The network is (768 -> HIDDEN_SIZE) x 2 -> 1. The 768 inputs are one for each piece type of each color in each square, and the first layer is computed for both perspectives: the accumulator of each color sees its own pieces as the first 384 inputs. The accumulators are updated with the pieces changed by each move instead of being computed again. The hidden layer is activated by a clipped ReLU, and the accumulator of the player to move is joined to the one of its opponent for the output.
+//      NNUE: [https://www.chessprogramming.org/NNUE]
+//  The weights are quantized to int16_t: the first layer by QA and the output layer by QB.
+//  File format: the little-endian int16_t values of the feature weights [768][HIDDEN_SIZE], the feature biases [HIDDEN_SIZE], the output weights [2 * HIDDEN_SIZE], the ones of the player to move first, and the output bias, quantized by QA * QB.
+//  The input of a piece is (own ? 0 : 384) + 64 * piece + square, with the pieces ordered pawn, knight, bishop, rook, queen, king, and the squares from a1 = 0 to h8 = 63 from the perspective's side, so the squares are flipped vertically for black.
+//  The inner loops use AVX2 or SSE4.1 when the compiler targets them, and plain loops otherwise.
+class NNUE {
+public:
+    static constexpr int INPUT_SIZE = 768;
+    static constexpr int HIDDEN_SIZE = 256;
+
+    //  Quantization of the weights, SCALE converts the output to centipawns
+    static constexpr int QA = 255;
+    static constexpr int QB = 64;
+    static constexpr int SCALE = 400;
+
+    //  The first layer of the network for a board, indexed by the color of the perspective
+    struct alignas(32) Accumulator {
+        int16_t values[2][HIDDEN_SIZE];
+    };
+
+    //  Loads the weights from the file. Returns false if it can't be read or its size doesn't match the network
+    bool load(const std::string& fileName);
+
+    //  Computes the accumulator of the board from scratch
+    void refresh(const Board& board, Accumulator& accumulator) const;
+
+    //  Computes the accumulator of the board after a move from the one before it, using the pieces changed by the move
+    void update(const Accumulator& previous, Accumulator& next, const Board::PieceChange* changes, int changesCount) const;
+
+    //  Returns the evaluation of the accumulator, in centipawns from the perspective of the player to move
+    int evaluate(const Accumulator& accumulator, PieceColor moveTurn) const;
+
+private:
+    struct alignas(32) Weights {
+        int16_t featureWeights[INPUT_SIZE][HIDDEN_SIZE];
+        int16_t featureBiases[HIDDEN_SIZE];
+        int16_t outputWeights[2 * HIDDEN_SIZE];
+        int16_t outputBias;
+    };
+
+    std::unique_ptr<Weights> weights;
+
+    //  The piece order of the inputs, indexed by PieceType
+    static constexpr int INPUT_PIECE_INDEX[12] = {0, 2, 1, 3, 4, 5, 0, 2, 1, 3, 4, 5};
+
+    //  Returns the input of the piece in the square from the perspective of the color, the square being the index of its bit in the board bitmaps
+    static int featureIndex(PieceColor perspective, PieceType pt, int square);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef PIECESQUARETABLES_HH
+#define PIECESQUARETABLES_HH
+
+#include "utils.hpp"
+#include "pieceSquareValues.hpp"
+
+//  A midgame and an endgame score packed in a single integer, so the evaluation terms can be added with one operation and blended once. The endgame score is stored in the upper 16 bits and the midgame score in the lower ones, both of them signed.
+//      Tapered Eval: [https://www.chessprogramming.org/Tapered_Eval]
+typedef int32_t PackedScore;
+
+constexpr PackedScore makeScore(int midgame, int endgame) {
+    return static_cast<PackedScore>(static_cast<uint32_t>(endgame) << 16) + midgame;
+}
+
+constexpr int midgameValue(PackedScore score) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score)));
+}
+
+constexpr int endgameValue(PackedScore score) {
+    //The midgame score borrows from the upper half when it's negative, adding 0x8000 gives it back
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score + 0x8000) >> 16));
+}
+
+//  Material and piece-square tables of the evaluation, with a midgame and an endgame set for each piece. The board keeps their sum and the game phase updated as pieces are added and removed, so the evaluation doesn't have to scan the board.
+//  The values are taken from PieceSquareValues, written from white's view. The black pieces use them mirrored vertically.
+//      PeSTO's Evaluation Function: [https://www.chessprogramming.org/PeSTO%27s_Evaluation_Function]
+class PieceSquareTables {
+public:
+    //  The game phase goes from MAX_PHASE with all the pieces on the board to 0 when only pawns and kings are left. Each knight and bishop counts 1, each rook 2 and each queen 4. With promotions it can go above MAX_PHASE
+    static constexpr int MAX_PHASE = 24;
+
+    //  Returns the packed score of the piece in the square, material included. The square is the index of the bit of the piece in the board bitmaps. The scores of the black pieces are negative
+    static constexpr PackedScore value(PieceType pt, int square) { return TABLE[pt][square]; }
+
+    //  Returns the weight of the piece in the game phase
+    static constexpr int phaseWeight(PieceType pt) { return PHASE_WEIGHTS[pt]; }
+
+private:
+    typedef std::array<std::array<PackedScore, 64>, 12> Table;
+
+    //  Indexed by PieceType
+    static constexpr int PHASE_WEIGHTS[12] = {0, 1, 1, 2, 4, 0, 0, 1, 1, 2, 4, 0};
+
+    //  Builds the packed score of each PieceType, indexed by square
+    static constexpr Table buildTable() {
+        const int (*midgame[6])[8] = {PieceSquareValues::MIDGAME_PAWN_TABLE, PieceSquareValues::MIDGAME_BISHOP_TABLE, PieceSquareValues::MIDGAME_KNIGHT_TABLE, PieceSquareValues::MIDGAME_ROOK_TABLE, PieceSquareValues::MIDGAME_QUEEN_TABLE, PieceSquareValues::MIDGAME_KING_TABLE};
+        const int (*endgame[6])[8] = {PieceSquareValues::ENDGAME_PAWN_TABLE, PieceSquareValues::ENDGAME_BISHOP_TABLE, PieceSquareValues::ENDGAME_KNIGHT_TABLE, PieceSquareValues::ENDGAME_ROOK_TABLE, PieceSquareValues::ENDGAME_QUEEN_TABLE, PieceSquareValues::ENDGAME_KING_TABLE};
+        Table table{};
+        for (int pt = 0; pt < 12; ++pt) {
+            bool white = pt < 6;
+            int piece = pt % 6;
+            for (int square = 0; square < 64; ++square) {
+                //The bit of the square (i, j) is 8*i + 7 - j, the row of the black pieces is mirrored
+                int i = square / 8, j = 7 - square % 8;
+                int row = white ? i : 7 - i;
+                int mg = PieceSquareValues::MIDGAME_PIECE_VALUES[piece] + midgame[piece][row][j];
+                int eg = PieceSquareValues::ENDGAME_PIECE_VALUES[piece] + endgame[piece][row][j];
+                table[pt][square] = white ? makeScore(mg, eg) : makeScore(-mg, -eg);
+            }
+        }
+        return table;
+    }
+
+    static const Table TABLE;
+};
+
+inline constexpr PieceSquareTables::Table PieceSquareTables::TABLE = PieceSquareTables::buildTable();
+
+#endif
@@ -17,6 +17,9 @@ public:
     //  Returns the move that the player wants to make
     virtual PieceMove getMove() = 0;
 
+    //  Informs the player of its remaining time in the clock and the increment it gets after each move. Only the engines use it
+    virtual void setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment);
+
     virtual void interrupt();
     bool wasInterrupted();
 
@@ -7,17 +7,23 @@
 #include <getopt.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cassert>
 #include <chrono>
 #include <climits>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <set>
 #include <string>
 #include <thread>
@@ -100,6 +106,9 @@ struct PieceMove {
         if (to.j != other.to.j) return to.j < other.to.j;
         return promoteTo < other.promoteTo;
     }
+    bool operator==(const PieceMove& other) const {
+        return from == other.from and to == other.to and promoteTo == other.promoteTo;
+    }
 
     //cout rule
     friend std::ostream& operator<<(std::ostream& os, const PieceMove& pm) {
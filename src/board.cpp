@@ -1,16 +1,30 @@
 #include "board.hpp"
 
 //  Static variables
-std::map<uint64_t, int> Board::boardStateCounter;
-std::list<Board> Board::boardLogList;
 Board::ZobristTable Board::zobristTable;
 
 Board::Board() { }
 
+Board::Board(const Board& other) {
+    *this = other;
+}
+
+Board& Board::operator=(const Board& other) {
+    restoreState(other);
+    lastMove = other.lastMove;
+    nullMoveLog = other.nullMoveLog;
+    boardStateCounter = other.boardStateCounter;
+    boardLogList = other.boardLogList;
+    return *this;
+}
+
 Board::~Board() { }
 
 void Board::setDefaulValues() {
     boardLogList.clear();
+    boardStateCounter.clear();
+    nullMoveLog.clear();
+    legalMovesPending = false;
 
     moveTurn = WHITE;
     boardResult = PLAYING;
@@ -44,19 +58,27 @@ void Board::setDefaulValues() {
     moveCounter = 0;
 
     initializeZobristTable();
+    zobristHash = calculateZobristHash();
+    pawnHash = calculatePawnHash();
+    calculateEvaluationScores();
 
     //Calculates the first legal moves
     calculateLegalMoves();
     
-    boardLogList.push_back(*this);
+    logState();
 }
 
 void Board::loadFEN(const std::string& FEN) {
     //Clears all the board data
+    boardLogList.clear();
+    boardStateCounter.clear();
+    nullMoveLog.clear();
+    legalMovesPending = false;
     allPieces = enPassant = castleBitmap = 0;
     whitePieces = whitePawn = whiteBishop = whiteKnight = whiteRook = whiteQueen = whiteKing = 0;
     blackPieces = blackPawn = blackBishop = blackKnight = blackRook = blackQueen = blackKing = 0;
     threefoldRepetition = false;
+    boardResult = PLAYING;
     moveCounter = 0;
 
     int index = 0; //The FEN string index
@@ -125,8 +147,8 @@ void Board::loadFEN(const std::string& FEN) {
     //Loads en passant data
     if (FEN[index] == '-') ++index;
     else {
-        int i = FEN[index] - 'a';
-        int j = FEN[index+1] - '1';
+        int j = FEN[index] - 'a';
+        int i = 7 - (FEN[index+1] - '1');
         if (i < 0 || i > 7 || j < 0 || j > 7) errorAndExit("Invalid FEN, wrong en passant data.");
         uint64_t bit;
         ijToBit(i, j, bit);
@@ -139,7 +161,7 @@ void Board::loadFEN(const std::string& FEN) {
 
     //Loads the halfmove clock, for 50 moves rule (not implemented)
     if (atoi(&FEN[index]) < 0) errorAndExit("Invalid FEN, wrong halfmove clock.");
-    ++index;
+    while (FEN[index] >= '0' && FEN[index] <= '9') ++index;
 
     if (FEN[index] != ' ') errorAndExit("Invalid FEN, wrong separator.");
     ++index;
@@ -147,21 +169,68 @@ void Board::loadFEN(const std::string& FEN) {
     //Loads the fullmove number
     if (atoi(&FEN[index]) < 0) errorAndExit("Invalid FEN, wrong fullmove number.");
     moveCounter = 2*atoi(&FEN[index]) + (moveTurn == BLACK);
-    ++index;
+    while (FEN[index] >= '0' && FEN[index] <= '9') ++index;
 
     if (index != FEN.size()) errorAndExit("Invalid FEN, wrong size.");
 
     initializeZobristTable();
+    zobristHash = calculateZobristHash();
+    pawnHash = calculatePawnHash();
+    calculateEvaluationScores();
     updateTargetedSquares(moveTurn == WHITE ? BLACK : WHITE); //Updates the squares targeted by the opponent
     calculateLegalMoves(); //Calculates my legal moves
-    boardLogList.push_back(*this);
+    logState();
+}
+
+std::string Board::getFEN() const {
+    const char PIECE_CHARS[12] = {'P', 'B', 'N', 'R', 'Q', 'K', 'p', 'b', 'n', 'r', 'q', 'k'};
+    std::string FEN;
+
+    //The pieces, from the 8th rank to the 1st one
+    for (int i = 0; i < 8; ++i) {
+        int emptySquares = 0;
+        for (int j = 0; j < 8; ++j) {
+            PieceType pt = getPieceType(i, j);
+            if (pt == NONE) {
+                ++emptySquares;
+                continue;
+            }
+            if (emptySquares > 0) FEN += char('0' + emptySquares);
+            emptySquares = 0;
+            FEN += PIECE_CHARS[pt];
+        }
+        if (emptySquares > 0) FEN += char('0' + emptySquares);
+        if (i < 7) FEN += '/';
+    }
+
+    FEN += (moveTurn == WHITE) ? " w " : " b ";
+
+    //The castle rights, in the order loadFEN reads them
+    std::string castle;
+    if (castleBitmap & 0x0200000000000000) castle += 'K';
+    if (castleBitmap & 0x2000000000000000) castle += 'Q';
+    if (castleBitmap & 0x0000000000000002) castle += 'k';
+    if (castleBitmap & 0x0000000000000020) castle += 'q';
+    FEN += castle.empty() ? "-" : castle;
+
+    if (enPassant) {
+        std::pair<int, int> square = bitToij(enPassant);
+        FEN += ' ';
+        FEN += char('a' + square.second);
+        FEN += char('1' + 7 - square.first);
+    }
+    else FEN += " -";
+
+    FEN += " 0 " + std::to_string(moveCounter / 2);
+    return FEN;
 }
 
 int Board::timesRepeated() const{
     uint64_t hash = getZobristHash();
-    if (boardStateCounter.find(hash) == boardStateCounter.end())
+    auto it = boardStateCounter.find(hash);
+    if (it == boardStateCounter.end())
         return 0;
-    return boardStateCounter[hash];
+    return it->second;
 
 }
 
@@ -203,7 +272,134 @@ bool Board::isCapture(const PieceMove& move) const{
 bool Board::isTargeted(const PieceMove& move) const{
     uint64_t toBit;
     ijToBit(move.to.i, move.to.j, toBit);
-    return (moveTurn == WHITE) ? (toBit & blackTargetedSquares) : (toBit & whiteTargetedSquares);
+    return (moveTurn == WHITE) ? (toBit & whiteTargetedSquares) : (toBit & blackTargetedSquares);
+}
+
+bool Board::givesCheck(const PieceMove& move) const{
+    uint64_t fromBit, toBit;
+    ijToBit(move.from.i, move.from.j, fromBit);
+    ijToBit(move.to.i, move.to.j, toBit);
+    PieceType fromPiece = bitToPieceType(fromBit);
+    bool white = fromPiece <= WHITE_KING;
+    uint64_t opponentKing = white ? blackKing : whiteKing;
+    if (!opponentKing) return false;
+
+    //The occupancy and my pieces as they would be after the move
+    uint64_t occupied = (allPieces & ~fromBit) | toBit;
+    uint64_t pawns = (white ? whitePawn : blackPawn) & ~fromBit;
+    uint64_t knights = (white ? whiteKnight : blackKnight) & ~fromBit;
+    uint64_t diagonals = (white ? whiteBishop | whiteQueen : blackBishop | blackQueen) & ~fromBit;
+    uint64_t lines = (white ? whiteRook | whiteQueen : blackRook | blackQueen) & ~fromBit;
+    switch (move.promoteTo != NONE ? move.promoteTo : fromPiece) {
+        case WHITE_PAWN: case BLACK_PAWN: pawns |= toBit; break;
+        case WHITE_KNIGHT: case BLACK_KNIGHT: knights |= toBit; break;
+        case WHITE_BISHOP: case BLACK_BISHOP: diagonals |= toBit; break;
+        case WHITE_ROOK: case BLACK_ROOK: lines |= toBit; break;
+        case WHITE_QUEEN: case BLACK_QUEEN: diagonals |= toBit; lines |= toBit; break;
+        default:;
+    }
+
+    //The pawn taken en passant leaves its square, and the castling rook moves next to the king
+    if ((fromPiece == WHITE_PAWN || fromPiece == BLACK_PAWN) && move.from.j != move.to.j && !(allPieces & toBit)) {
+        uint64_t takenBit;
+        ijToBit(move.from.i, move.to.j, takenBit);
+        occupied &= ~takenBit;
+    }
+    else if ((fromPiece == WHITE_KING || fromPiece == BLACK_KING) && move.from.j == 4 && (move.to.j == 6 || move.to.j == 2)) {
+        uint64_t rookFrom, rookTo;
+        ijToBit(move.from.i, move.to.j == 6 ? 7 : 0, rookFrom);
+        ijToBit(move.from.i, move.to.j == 6 ? 5 : 3, rookTo);
+        occupied = (occupied & ~rookFrom) | rookTo;
+        lines = (lines & ~rookFrom) | rookTo;
+    }
+
+    //A pawn attacks the king from the squares where a pawn of the opponent on the king would attack, and the sliding pieces are blocked by the occupancy after the move
+    int kingSquare = __builtin_ctzll(opponentKing);
+    return (Attacks::pawns(opponentKing, white ? BLACK : WHITE) & pawns)
+        || (Attacks::knight(kingSquare) & knights)
+        || (Attacks::bishop(kingSquare, occupied) & diagonals)
+        || (Attacks::rook(kingSquare, occupied) & lines);
+}
+
+int Board::staticExchangeEvaluation(const PieceMove& move, const int* pieceValues) const{
+    uint64_t fromBit, toBit;
+    ijToBit(move.from.i, move.from.j, fromBit);
+    ijToBit(move.to.i, move.to.j, toBit);
+    PieceType attacker = bitToPieceType(fromBit);
+    PieceType victim = bitToPieceType(toBit);
+    uint64_t occupied = allPieces & ~fromBit;
+
+    //gain[d] is the balance of the sequence for the player that makes the capture d if the sequence stops after it
+    int gain[32];
+    int d = 0;
+    gain[0] = 0;
+    if (victim != NONE) gain[0] = pieceValues[victim];
+    else if (isCapture(move)) {
+        //En passant, the captured pawn is next to the pawn that moves
+        uint64_t capturedBit;
+        ijToBit(move.from.i, move.to.j, capturedBit);
+        occupied &= ~capturedBit;
+        gain[0] = pieceValues[WHITE_PAWN];
+    }
+
+    //The value of the piece that stands on the square, a promoted pawn will be captured as its new piece
+    int pieceOnSquareValue = pieceValues[attacker];
+    if (move.promoteTo != NONE) {
+        gain[0] += pieceValues[move.promoteTo] - pieceValues[attacker];
+        pieceOnSquareValue = pieceValues[move.promoteTo];
+    }
+
+    PieceColor side = (fromBit & whitePieces) ? BLACK : WHITE;
+    while (d < 31) {
+        uint64_t sideAttackers = getAttackers(move.to.i, move.to.j, occupied) & (side == WHITE ? whitePieces : blackPieces);
+        if (sideAttackers == 0) break;
+
+        //The least valuable attacker makes the capture
+        uint64_t leastValuableBit = 0;
+        int leastValue = 0;
+        for (uint64_t bits = sideAttackers; bits; bits &= bits - 1) {
+            uint64_t bit = bits & -bits;
+            int value = pieceValues[bitToPieceType(bit)];
+            if (leastValuableBit == 0 || value < leastValue) {
+                leastValuableBit = bit;
+                leastValue = value;
+            }
+        }
+
+        ++d;
+        gain[d] = pieceOnSquareValue - gain[d - 1];
+        //If the previous capture wins material and this one can't recover it, the player stops and the sign of the result won't change
+        if (std::max(-gain[d - 1], gain[d]) < 0) {
+            --d;
+            break;
+        }
+
+        occupied &= ~leastValuableBit;
+        pieceOnSquareValue = leastValue;
+        side = (side == WHITE) ? BLACK : WHITE;
+    }
+
+    //Each player only makes the capture if it's better than stopping
+    for (; d > 0; --d) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    return gain[0];
+}
+
+uint64_t Board::getPieceBitmap(PieceType pt) const{
+    switch(pt) {
+        case WHITE_PAWN: return whitePawn;
+        case WHITE_BISHOP: return whiteBishop;
+        case WHITE_KNIGHT: return whiteKnight;
+        case WHITE_ROOK: return whiteRook;
+        case WHITE_QUEEN: return whiteQueen;
+        case WHITE_KING: return whiteKing;
+        case BLACK_PAWN: return blackPawn;
+        case BLACK_BISHOP: return blackBishop;
+        case BLACK_KNIGHT: return blackKnight;
+        case BLACK_ROOK: return blackRook;
+        case BLACK_QUEEN: return blackQueen;
+        case BLACK_KING: return blackKing;
+        default: return 0;
+    }
 }
 
 int Board::getAllPiecesCount() const{
@@ -247,11 +443,15 @@ int Board::getKingsCount(PieceColor col) const{
 
 void Board::movePiece(PieceMove& move) {
     //Checks if the move is legal
-    if (legalMoves.find(move) == legalMoves.end()) {
+    const std::set<PieceMove>& moves = getCurrentLegalMoves();
+    if (moves.find(move) == moves.end()) {
         std::cout << "[ERROR] Invalid Move!\n";
         return;
     }
     
+    //The turn, castle rights and en passant square will change, their old values are removed from the hash
+    zobristHash ^= stateZobristHash();
+
     //If the moves is a pown that moves two squares, it updates the board info in order to let en passant
     updateEnPassant(move);
 
@@ -267,6 +467,7 @@ void Board::movePiece(PieceMove& move) {
     //Toggles the turn
     moveTurn = (moveTurn == WHITE) ? BLACK : WHITE;
     ++moveCounter;
+    zobristHash ^= stateZobristHash();
 
     //Calculates the legal moves of the opponent
     calculateLegalMoves();
@@ -292,42 +493,58 @@ void Board::undoMove() {
 
     //The back element is the current state, so it will be removed
     boardLogList.pop_back();
-    Board *prevBoard = &boardLogList.back();
-
-    moveTurn = prevBoard->moveTurn;
-    moveCounter = prevBoard->moveCounter;
-    legalMoves = prevBoard->legalMoves;
-    threefoldRepetition = prevBoard->threefoldRepetition;
-    boardResult = prevBoard->boardResult;
-    allPieces = prevBoard->allPieces;
-    enPassant = prevBoard->enPassant;
-    castleBitmap = prevBoard->castleBitmap;
-    whitePieces = prevBoard->whitePieces;
-    whiteTargetedSquares = prevBoard->whiteTargetedSquares;
-    whitePinnedSquares = prevBoard->whitePinnedSquares;
-    blackPieces = prevBoard->blackPieces;
-    blackTargetedSquares = prevBoard->blackTargetedSquares;
-    blackPinnedSquares = prevBoard->blackPinnedSquares;
-    whitePawn = prevBoard->whitePawn;
-    whiteBishop = prevBoard->whiteBishop;
-    whiteKnight = prevBoard->whiteKnight;
-    whiteRook = prevBoard->whiteRook;
-    whiteQueen = prevBoard->whiteQueen;
-    whiteKing = prevBoard->whiteKing;
-    blackPawn = prevBoard->blackPawn;
-    blackBishop = prevBoard->blackBishop;
-    blackKnight = prevBoard->blackKnight;
-    blackRook = prevBoard->blackRook;
-    blackQueen = prevBoard->blackQueen;
-    blackKing = prevBoard->blackKing;
-}
-
-const std::set<PieceMove>& Board::getCurrentLegalMoves() const {
+    restoreState(boardLogList.back());
+}
+
+void Board::makeNullMove() {
+    nullMoveLog.push_back({zobristHash, enPassant, pieceChangesCount, whiteTargetedSquares, whitePinnedSquares, blackTargetedSquares, blackPinnedSquares});
+
+    zobristHash ^= stateZobristHash();
+    enPassant = 0;
+    pieceChangesCount = 0;
+    moveTurn = (moveTurn == WHITE) ? BLACK : WHITE;
+    zobristHash ^= stateZobristHash();
+
+    //No piece has moved, so only the squares targeted by the player that passed have to be updated, they tell if a king is in check. The legal moves of the new player are left for getCurrentLegalMoves
+    updateTargetedSquares(moveTurn == WHITE ? BLACK : WHITE);
+    legalMovesPending = true;
+}
+
+void Board::undoNullMove() {
+    if (legalMovesPending) {
+        //Nothing has been logged since the null move, only what it changed is restored
+        const NullMoveState& state = nullMoveLog.back();
+        zobristHash = state.zobristHash;
+        enPassant = state.enPassant;
+        pieceChangesCount = state.pieceChangesCount;
+        whiteTargetedSquares = state.whiteTargetedSquares;
+        whitePinnedSquares = state.whitePinnedSquares;
+        blackTargetedSquares = state.blackTargetedSquares;
+        blackPinnedSquares = state.blackPinnedSquares;
+        moveTurn = (moveTurn == WHITE) ? BLACK : WHITE;
+        legalMovesPending = false;
+    }
+    else {
+        //The board after the null move was logged with its legal moves, the back element of the log is the one before it
+        boardLogList.pop_back();
+        restoreState(boardLogList.back());
+    }
+    nullMoveLog.pop_back();
+}
+
+const std::set<PieceMove>& Board::getCurrentLegalMoves() {
+    if (legalMovesPending) {
+        legalMovesPending = false;
+        calculateLegalMoves();
+
+        //The state is logged, so that the moves made from here are undone to it. It doesn't count for the threefold repetition
+        logState();
+    }
     return legalMoves;
 }
 
-void Board::getCurrentTakes(std::set<PieceMove>& takes) const{
-    for (PieceMove move : legalMoves) {
+void Board::getCurrentTakes(std::set<PieceMove>& takes) {
+    for (PieceMove move : getCurrentLegalMoves()) {
         if (isCapture(move))
             takes.insert(move);
     }
@@ -381,30 +598,100 @@ void Board::printResult() const{
 }
 
 void Board::initializeZobristTable() {
-    for (int i = 0; i < 64; ++i) {
-        for (int j = 0; j < 12; ++j) {
-            zobristTable.zobristPieces[i][j] = rand_uint64();
+    //Boards may be created by several threads at the same time, the table is filled by only one of them and the rest wait for it
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        for (int i = 0; i < 64; ++i) {
+            for (int j = 0; j < 12; ++j) {
+                zobristTable.zobristPieces[i][j] = rand_uint64();
+            }
         }
-    }
-    zobristTable.zobristMoveTurn = rand_uint64();
-    zobristTable.zobristCastle = rand_uint64();
-    zobristTable.zobrsitEnPassant = rand_uint64();
+        zobristTable.zobristMoveTurn = rand_uint64();
+        for (int i = 0; i < 4; ++i) zobristTable.zobristCastle[i] = rand_uint64();
+        for (int i = 0; i < 8; ++i) zobristTable.zobristEnPassant[i] = rand_uint64();
+    });
+}
+
+bool Board::isInCheck() const{
+    if (moveTurn == WHITE) return whiteKing & whiteTargetedSquares;
+    else return blackKing & blackTargetedSquares;
 }
 
 uint64_t Board::getZobristHash() const{
-    uint64_t hash = 0;
-    PieceType currentPieceType;
+    return zobristHash;
+}
+
+uint64_t Board::getPawnHash() const{
+    return pawnHash;
+}
+
+uint64_t Board::getMaterialKey() const{
+    return materialKey;
+}
+
+PackedScore Board::getPieceSquareScore() const {
+    return pieceSquareScore;
+}
+
+int Board::getPhase() const {
+    return phase;
+}
+
+const Board::PieceChange* Board::getPieceChanges() const {
+    return pieceChanges;
+}
+
+int Board::getPieceChangesCount() const {
+    return pieceChangesCount;
+}
+
+void Board::calculateEvaluationScores() {
+    pieceSquareScore = 0;
+    phase = 0;
+    materialKey = 0;
+    pieceChangesCount = 0;
     uint64_t bit = 1;
-    if (moveTurn == BLACK) hash ^= zobristTable.zobristMoveTurn;
-    hash ^= zobristTable.zobristCastle;
-    hash ^= castleBitmap;
     for (int i = 0; i < 64; ++i) {
         if (bit & allPieces) {
-            currentPieceType = bitToPieceType(bit);
-            hash ^= zobristTable.zobristPieces[i][currentPieceType];
+            PieceType pt = bitToPieceType(bit);
+            pieceSquareScore += PieceSquareTables::value(pt, i);
+            phase += PieceSquareTables::phaseWeight(pt);
+            materialKey += uint64_t(1) << (4 * pt);
         }
         bit = bit << 1;
     }
+}
+
+uint64_t Board::calculateZobristHash() const{
+    uint64_t hash = stateZobristHash();
+    uint64_t bit = 1;
+    for (int i = 0; i < 64; ++i) {
+        if (bit & allPieces)
+            hash ^= zobristTable.zobristPieces[i][bitToPieceType(bit)];
+        bit = bit << 1;
+    }
+    return hash;
+}
+
+uint64_t Board::calculatePawnHash() const{
+    uint64_t hash = 0;
+    uint64_t bit = 1;
+    for (int i = 0; i < 64; ++i) {
+        if (bit & whitePawn) hash ^= zobristTable.zobristPieces[i][WHITE_PAWN];
+        else if (bit & blackPawn) hash ^= zobristTable.zobristPieces[i][BLACK_PAWN];
+        bit = bit << 1;
+    }
+    return hash;
+}
+
+uint64_t Board::stateZobristHash() const{
+    uint64_t hash = 0;
+    if (moveTurn == BLACK) hash ^= zobristTable.zobristMoveTurn;
+    if (castleBitmap & 0x0200000000000000) hash ^= zobristTable.zobristCastle[0];
+    if (castleBitmap & 0x2000000000000000) hash ^= zobristTable.zobristCastle[1];
+    if (castleBitmap & 0x0000000000000002) hash ^= zobristTable.zobristCastle[2];
+    if (castleBitmap & 0x0000000000000020) hash ^= zobristTable.zobristCastle[3];
+    if (enPassant) hash ^= zobristTable.zobristEnPassant[bitToij(enPassant).second];
     return hash;
 }
 
@@ -621,8 +908,9 @@ void Board::manageCheck(std::set<PieceMove> &legalMoves) {
         uint64_t fromBit;
         ijToBit(move.from.i, move.from.j, fromBit);     
 
-        //Explanation: a copy of the class board (baux) is created. Baux will make the move, and if the king is still targeted, the move will be removed from the legalMoves set. (should be done better without creating a new board)
-        Board baux = *this;
+        //Explanation: a copy of the class board (baux) is created, without the log. Baux will make the move, and if the king is still targeted, the move will be removed from the legalMoves set. (should be done better without creating a new board)
+        Board baux;
+        baux.restoreState(*this);
         baux.makeAMove(move);
         baux.moveTurn = (baux.moveTurn == WHITE) ? BLACK : WHITE;
         baux.updateTargetedSquares(baux.moveTurn);
@@ -649,9 +937,10 @@ void Board::eliminatePinnedCheckMoves(std::set<PieceMove> &legalMoves) {
         uint64_t fromBit;
         ijToBit(move.from.i, move.from.j, fromBit);
 
-        //Explanation: a copy of the class board (baux) is created. Baux will make the move, and if the king is still targeted, the move will be removed from the legalMoves set. (should be done better without creating a new board)
+        //Explanation: a copy of the class board (baux) is created, without the log. Baux will make the move, and if the king is still targeted, the move will be removed from the legalMoves set. (should be done better without creating a new board)
         if (*myPinnedSquares & fromBit) {
-            Board baux = *this;
+            Board baux;
+            baux.restoreState(*this);
             baux.makeAMove(move);
             baux.moveTurn = (baux.moveTurn == WHITE) ? BLACK : WHITE;
             baux.updateTargetedSquares(baux.moveTurn);
@@ -669,103 +958,161 @@ void Board::eliminatePinnedCheckMoves(std::set<PieceMove> &legalMoves) {
 }
 
 void Board::makeAMove(const PieceMove& move) {
+    //Only the pieces changed by this move are recorded
+    pieceChangesCount = 0;
+
     uint64_t fromBit, toBit;
-    uint64_t *fromPieceBitmap, *toPieceBitmap;
     
     ijToBit(move.from.i, move.from.j, fromBit);
     ijToBit(move.to.i, move.to.j, toBit);
     
-    fromPieceBitmap = bitToPieceBitmap(fromBit);
-    toPieceBitmap = bitToPieceBitmap(toBit);
+    PieceType fromPiece = bitToPieceType(fromBit);
+    PieceType toPiece = bitToPieceType(toBit);
 
     //If the move is a promotion, it will change the piece
     if (move.promoteTo != NONE) {
-        if (toPieceBitmap != nullptr)
-            removePiece(*toPieceBitmap, toBit);
-        uint64_t *promoteToBitmap = pieceTypeToBitmap(move.promoteTo);
-        addPiece(*promoteToBitmap, moveTurn, toBit);
-        removePiece(*fromPieceBitmap, fromBit);
+        if (toPiece != NONE)
+            removePiece(toPiece, toBit);
+        addPiece(move.promoteTo, toBit);
+        removePiece(fromPiece, fromBit);
         return;
     }
     //If the move is a capture, it will remove the piece from the target location
-    if (toPieceBitmap != nullptr)
-        removePiece(*toPieceBitmap, toBit);
+    if (toPiece != NONE)
+        removePiece(toPiece, toBit);
     else {
         //Detects and manages the en passant move
-        if ((*fromPieceBitmap & whitePawn) && (move.from.j != move.to.j)) {
-            uint64_t aux = toBit << 8;
-            removePiece(blackPawn, aux);
-        }
-        else if (*fromPieceBitmap & blackPawn && move.from.j != move.to.j) {
-            uint64_t aux = toBit >> 8;
-            removePiece(whitePawn, aux);
-        }
+        if (fromPiece == WHITE_PAWN && move.from.j != move.to.j)
+            removePiece(BLACK_PAWN, toBit << 8);
+        else if (fromPiece == BLACK_PAWN && move.from.j != move.to.j)
+            removePiece(WHITE_PAWN, toBit >> 8);
         //Detects if a castle move is being done, if so, it will move the rook
-        manageCastleMove(*fromPieceBitmap, move);
+        manageCastleMove(fromPiece, move);
     }
     //Add the piece to its new location
-    addPiece(*fromPieceBitmap, moveTurn, toBit);
+    addPiece(fromPiece, toBit);
     
     //Remove the piece from it last location
-    removePiece(*fromPieceBitmap, fromBit);
+    removePiece(fromPiece, fromBit);
 }
 
-void Board::removePiece(uint64_t& targetBitMap, uint64_t bit) {
+void Board::removePiece(PieceType pt, uint64_t bit) {
     allPieces = allPieces & ~bit;
-    if (targetBitMap & whitePieces)
+    if (pieceColor(pt) == WHITE)
         whitePieces = whitePieces & ~bit;
     else
         blackPieces = blackPieces & ~bit;
-    targetBitMap = targetBitMap & ~bit;
+    uint64_t *targetBitMap = pieceTypeToBitmap(pt);
+    *targetBitMap = *targetBitMap & ~bit;
+    int square = __builtin_ctzll(bit);
+    zobristHash ^= zobristTable.zobristPieces[square][pt];
+    if (pt == WHITE_PAWN || pt == BLACK_PAWN) pawnHash ^= zobristTable.zobristPieces[square][pt];
+    pieceSquareScore -= PieceSquareTables::value(pt, square);
+    phase -= PieceSquareTables::phaseWeight(pt);
+    materialKey -= uint64_t(1) << (4 * pt);
+    assert(pieceChangesCount < MAX_PIECE_CHANGES);
+    pieceChanges[pieceChangesCount++] = {pt, uint8_t(square), false};
 }
 
-void Board::addPiece(uint64_t& targetBitMap, PieceColor col, uint64_t bit) {
+void Board::addPiece(PieceType pt, uint64_t bit) {
     allPieces = allPieces | bit;
-    if (col == WHITE) 
+    if (pieceColor(pt) == WHITE) 
         whitePieces = whitePieces | bit;
     else 
         blackPieces = blackPieces | bit;
-    targetBitMap = targetBitMap | bit;
+    uint64_t *targetBitMap = pieceTypeToBitmap(pt);
+    *targetBitMap = *targetBitMap | bit;
+    int square = __builtin_ctzll(bit);
+    zobristHash ^= zobristTable.zobristPieces[square][pt];
+    if (pt == WHITE_PAWN || pt == BLACK_PAWN) pawnHash ^= zobristTable.zobristPieces[square][pt];
+    pieceSquareScore += PieceSquareTables::value(pt, square);
+    phase += PieceSquareTables::phaseWeight(pt);
+    materialKey += uint64_t(1) << (4 * pt);
+    assert(pieceChangesCount < MAX_PIECE_CHANGES);
+    pieceChanges[pieceChangesCount++] = {pt, uint8_t(square), true};
 }
 
-void Board::manageCastleMove(uint64_t fromPieceBitmap, const PieceMove& move) {
+void Board::manageCastleMove(PieceType fromPiece, const PieceMove& move) {
     //If the move is a castle move, it will move the rook, and disable the castling
-    if (fromPieceBitmap & whiteKing && move.from.j == 4 && move.to.j == 6) {
+    if (fromPiece == WHITE_KING && move.from.j == 4 && move.to.j == 6) {
         uint64_t rookFrom = 0x0100000000000000;
         uint64_t rookTo = 0x0400000000000000;
-        addPiece(whiteRook, moveTurn, rookTo);
-        removePiece(whiteRook, rookFrom);
+        addPiece(WHITE_ROOK, rookTo);
+        removePiece(WHITE_ROOK, rookFrom);
         castleBitmap = castleBitmap & ~0x2200000000000000;
     }
-    else if (fromPieceBitmap & whiteKing && move.from.j == 4 && move.to.j == 2) {
+    else if (fromPiece == WHITE_KING && move.from.j == 4 && move.to.j == 2) {
         uint64_t rookFrom = 0x8000000000000000;
         uint64_t rookTo = 0x1000000000000000;
-        addPiece(whiteRook, moveTurn, rookTo);
-        removePiece(whiteRook, rookFrom);
+        addPiece(WHITE_ROOK, rookTo);
+        removePiece(WHITE_ROOK, rookFrom);
         castleBitmap = castleBitmap & ~0x220000000000000;
     }
-    else if (fromPieceBitmap & blackKing && move.from.j == 4 && move.to.j == 6) {
+    else if (fromPiece == BLACK_KING && move.from.j == 4 && move.to.j == 6) {
         uint64_t rookFrom = 0x0000000000000001;
         uint64_t rookTo = 0x0000000000000004;
-        addPiece(blackRook, moveTurn, rookTo);
-        removePiece(blackRook, rookFrom);
+        addPiece(BLACK_ROOK, rookTo);
+        removePiece(BLACK_ROOK, rookFrom);
         castleBitmap = castleBitmap & ~0x0000000000000022;
     }
-    else if (fromPieceBitmap & blackKing && move.from.j == 4 && move.to.j == 2) {
+    else if (fromPiece == BLACK_KING && move.from.j == 4 && move.to.j == 2) {
         uint64_t rookFrom = 0x0000000000000080;
         uint64_t rookTo = 0x0000000000000010;
-        addPiece(blackRook, moveTurn, rookTo);
-        removePiece(blackRook, rookFrom);
+        addPiece(BLACK_ROOK, rookTo);
+        removePiece(BLACK_ROOK, rookFrom);
         castleBitmap = castleBitmap & ~0x0000000000000022;
     }
 }
 
+void Board::restoreState(const Board& prevBoard) {
+    moveTurn = prevBoard.moveTurn;
+    moveCounter = prevBoard.moveCounter;
+    legalMoves = prevBoard.legalMoves;
+    legalMovesPending = prevBoard.legalMovesPending;
+    threefoldRepetition = prevBoard.threefoldRepetition;
+    boardResult = prevBoard.boardResult;
+    zobristHash = prevBoard.zobristHash;
+    pawnHash = prevBoard.pawnHash;
+    materialKey = prevBoard.materialKey;
+    pieceSquareScore = prevBoard.pieceSquareScore;
+    phase = prevBoard.phase;
+    std::copy(prevBoard.pieceChanges, prevBoard.pieceChanges + prevBoard.pieceChangesCount, pieceChanges);
+    pieceChangesCount = prevBoard.pieceChangesCount;
+    allPieces = prevBoard.allPieces;
+    enPassant = prevBoard.enPassant;
+    castleBitmap = prevBoard.castleBitmap;
+    whitePieces = prevBoard.whitePieces;
+    whiteTargetedSquares = prevBoard.whiteTargetedSquares;
+    whitePinnedSquares = prevBoard.whitePinnedSquares;
+    blackPieces = prevBoard.blackPieces;
+    blackTargetedSquares = prevBoard.blackTargetedSquares;
+    blackPinnedSquares = prevBoard.blackPinnedSquares;
+    whitePawn = prevBoard.whitePawn;
+    whiteBishop = prevBoard.whiteBishop;
+    whiteKnight = prevBoard.whiteKnight;
+    whiteRook = prevBoard.whiteRook;
+    whiteQueen = prevBoard.whiteQueen;
+    whiteKing = prevBoard.whiteKing;
+    blackPawn = prevBoard.blackPawn;
+    blackBishop = prevBoard.blackBishop;
+    blackKnight = prevBoard.blackKnight;
+    blackRook = prevBoard.blackRook;
+    blackQueen = prevBoard.blackQueen;
+    blackKing = prevBoard.blackKing;
+}
+
+void Board::logState() {
+    //The board is default constructed in the list, so its log is empty, and only the state is copied
+    boardLogList.emplace_back();
+    boardLogList.back().restoreState(*this);
+}
+
 void Board::registerState() {
     uint64_t hash = getZobristHash();
     boardStateCounter[hash] += 1;
     if (boardStateCounter[hash] == 3)
         threefoldRepetition = true;
-    boardLogList.push_back(*this);
+    logState();
 }
 
 std::pair<uint16_t,uint16_t> Board::bitToij(uint64_t bit) const {
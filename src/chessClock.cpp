@@ -0,0 +1,84 @@
+#include "chessClock.hpp"
+
+ChessClock::ChessClock() {
+    enabled = false;
+    increment = std::chrono::milliseconds(0);
+    remaining[WHITE] = remaining[BLACK] = std::chrono::milliseconds(0);
+    runningColor = lastMoveColor = NONE_COLOR;
+    lastMoveTime = std::chrono::milliseconds(0);
+    movesCount[WHITE] = movesCount[BLACK] = 0;
+    totalTime[WHITE] = totalTime[BLACK] = std::chrono::milliseconds(0);
+    maxTime[WHITE] = maxTime[BLACK] = std::chrono::milliseconds(0);
+}
+
+void ChessClock::setTimeControl(std::chrono::milliseconds initialTime, std::chrono::milliseconds inc) {
+    enabled = true;
+    increment = inc;
+    remaining[WHITE] = remaining[BLACK] = initialTime;
+}
+
+bool ChessClock::isEnabled() const {
+    return enabled;
+}
+
+void ChessClock::start(PieceColor col) {
+    runningColor = col;
+    turnStart = std::chrono::steady_clock::now();
+}
+
+std::chrono::milliseconds ChessClock::stop() {
+    if (runningColor == NONE_COLOR) return std::chrono::milliseconds(0);
+
+    std::chrono::milliseconds used = currentTurnTime();
+    remaining[runningColor] -= used;
+    if (remaining[runningColor] > std::chrono::milliseconds(0)) remaining[runningColor] += increment;
+
+    //Statistics
+    ++movesCount[runningColor];
+    totalTime[runningColor] += used;
+    maxTime[runningColor] = std::max(maxTime[runningColor], used);
+
+    lastMoveColor = runningColor;
+    lastMoveTime = used;
+    runningColor = NONE_COLOR;
+    return used;
+}
+
+PieceColor ChessClock::getRunningColor() const {
+    return runningColor;
+}
+
+std::chrono::milliseconds ChessClock::getRemaining(PieceColor col) const {
+    if (col == runningColor) return remaining[col] - currentTurnTime();
+    return remaining[col];
+}
+
+std::chrono::milliseconds ChessClock::getIncrement() const {
+    return increment;
+}
+
+bool ChessClock::flagFell(PieceColor col) const {
+    return enabled && getRemaining(col) <= std::chrono::milliseconds(0);
+}
+
+void ChessClock::printLastMove() const {
+    if (!enabled || lastMoveColor == NONE_COLOR) return;
+    std::cout << "[CLOCK] " << pieceColorToString(lastMoveColor) << " used " << lastMoveTime.count() / 1000.0 << " s, remaining " << remaining[lastMoveColor].count() / 1000.0 << " s" << std::endl;
+}
+
+void ChessClock::printStatistics() const {
+    if (!enabled) return;
+    std::cout << "Time per move statistics:" << std::endl;
+    for (PieceColor col : {WHITE, BLACK}) {
+        double average = movesCount[col] > 0 ? totalTime[col].count() / 1000.0 / movesCount[col] : 0.0;
+        std::cout << "    - " << pieceColorToString(col) << ": " << movesCount[col] << " moves, "
+                  << "total " << totalTime[col].count() / 1000.0 << " s, "
+                  << "average " << average << " s, "
+                  << "max " << maxTime[col].count() / 1000.0 << " s, "
+                  << "remaining " << std::max(std::chrono::milliseconds(0), remaining[col]).count() / 1000.0 << " s" << std::endl;
+    }
+}
+
+std::chrono::milliseconds ChessClock::currentTurnTime() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStart);
+}
@@ -0,0 +1,132 @@
+#include "engine_v1.hpp"
+#include "board.hpp"
+
+const MaterialTable::materialTableEntry* EngineV1::probeMaterial() {
+    uint64_t materialKey = board->getMaterialKey();
+    MaterialTable::materialTableEntry* entry = materialTable.getEntry(materialKey);
+    if (entry->materialKey != materialKey) calculateMaterial(materialKey, *entry);
+    return entry;
+}
+
+void EngineV1::calculateMaterial(uint64_t materialKey, MaterialTable::materialTableEntry& entry) {
+    //The material key has 4 bits for the count of each piece type
+    int count[12];
+    for (int pt = 0; pt < 12; ++pt) count[pt] = (materialKey >> (4 * pt)) & 15;
+
+    entry = {materialKey, 0, MaterialTable::NO_ENDGAME, WHITE, {MaterialTable::SCALE_FACTOR_NORMAL, MaterialTable::SCALE_FACTOR_NORMAL}};
+
+    int pawns[2], knights[2], bishops[2], rooks[2], queens[2], nonPawnMaterial[2];
+    for (int col = WHITE; col <= BLACK; ++col) {
+        const int* colorCount = count + (col == WHITE ? 0 : 6);
+        pawns[col] = colorCount[WHITE_PAWN];
+        knights[col] = colorCount[WHITE_KNIGHT];
+        bishops[col] = colorCount[WHITE_BISHOP];
+        rooks[col] = colorCount[WHITE_ROOK];
+        queens[col] = colorCount[WHITE_QUEEN];
+        nonPawnMaterial[col] = knights[col] * KNIGHT_VALUE + bishops[col] * BISHOP_VALUE + rooks[col] * ROOK_VALUE + queens[col] * QUEEN_VALUE;
+
+        PackedScore imbalance = (bishops[col] >= 2 ? BISHOP_PAIR_BONUS : 0)
+                              + KNIGHT_PAWN_ADJUSTMENT * knights[col] * (pawns[col] - IMBALANCE_PAWNS)
+                              + ROOK_PAWN_ADJUSTMENT * rooks[col] * (pawns[col] - IMBALANCE_PAWNS);
+        entry.imbalance += (col == WHITE) ? imbalance : -imbalance;
+    }
+
+    for (int col = WHITE; col <= BLACK; ++col) {
+        int opponent = (col == WHITE) ? BLACK : WHITE;
+        bool loneOpponentKing = pawns[opponent] == 0 && nonPawnMaterial[opponent] == 0;
+
+        if (loneOpponentKing) {
+            MaterialTable::EndgameType endgame = MaterialTable::NO_ENDGAME;
+            if (pawns[col] == 0 && knights[col] == 1 && bishops[col] == 1 && rooks[col] == 0 && queens[col] == 0) endgame = MaterialTable::KBNK_ENDGAME;
+            else if (pawns[col] == 1 && nonPawnMaterial[col] == 0) endgame = MaterialTable::KPK_ENDGAME;
+            else if (queens[col] > 0 || rooks[col] > 0 || bishops[col] >= 2) endgame = MaterialTable::KXK_ENDGAME;
+
+            if (endgame != MaterialTable::NO_ENDGAME) {
+                entry.endgame = endgame;
+                entry.strongSide = PieceColor(col);
+            }
+        }
+
+        //Without pawns, a side that is less than a rook ahead can't win unless it has a lot of material, and two knights can't force mate
+        if (pawns[col] == 0 && nonPawnMaterial[col] - nonPawnMaterial[opponent] <= BISHOP_VALUE)
+            entry.scaleFactor[col] = nonPawnMaterial[col] < ROOK_VALUE ? 0 : (nonPawnMaterial[opponent] <= BISHOP_VALUE ? 4 : 14);
+        if (pawns[col] == 0 && loneOpponentKing && nonPawnMaterial[col] == 2 * KNIGHT_VALUE && knights[col] == 2)
+            entry.scaleFactor[col] = 0;
+    }
+
+    bool onlyBishops = true;
+    for (int col = WHITE; col <= BLACK; ++col)
+        onlyBishops = onlyBishops && bishops[col] == 1 && knights[col] == 0 && rooks[col] == 0 && queens[col] == 0;
+    if (entry.endgame == MaterialTable::NO_ENDGAME && onlyBishops) entry.endgame = MaterialTable::BISHOPS_ENDGAME;
+}
+
+bool EngineV1::evaluateEndgame(const MaterialTable::materialTableEntry& material, int& evaluation) {
+    PieceColor strongSide = material.strongSide;
+    PieceColor weakSide = (strongSide == WHITE) ? BLACK : WHITE;
+    int strongKing = __builtin_ctzll(board->getPieceBitmap(strongSide == WHITE ? WHITE_KING : BLACK_KING));
+    int weakKing = __builtin_ctzll(board->getPieceBitmap(weakSide == WHITE ? WHITE_KING : BLACK_KING));
+
+    //The material and piece-square score of the strong side, which decides between won endgames
+    int strongMaterial = endgameValue(board->getPieceSquareScore()) * (strongSide == WHITE ? 1 : -1);
+    int score;
+
+    switch (material.endgame) {
+    case MaterialTable::KXK_ENDGAME:
+        score = strongMaterial + KNOWN_WIN_BONUS + PUSH_TO_EDGE_BONUS * (3 - edgeDistance(weakKing)) + PUSH_CLOSE_BONUS * (7 - squareDistance(strongKing, weakKing));
+        break;
+
+    case MaterialTable::KBNK_ENDGAME: {
+        //The mate can only be forced in a corner of the color of the bishop, a1 (bit 63) and h8 (bit 0) are the dark ones
+        int bishop = __builtin_ctzll(board->getPieceBitmap(strongSide == WHITE ? WHITE_BISHOP : BLACK_BISHOP));
+        bool darkBishop = (bishop / 8 + bishop % 8) % 2 == 0;
+        int cornerDistance = darkBishop ? std::min(squareDistance(weakKing, 0), squareDistance(weakKing, 63))
+                                        : std::min(squareDistance(weakKing, 7), squareDistance(weakKing, 56));
+        score = strongMaterial + KNOWN_WIN_BONUS + PUSH_TO_CORNER_BONUS * (7 - cornerDistance) + PUSH_CLOSE_BONUS * (7 - squareDistance(strongKing, weakKing));
+        break;
+    }
+
+    case MaterialTable::KPK_ENDGAME: {
+        int pawn = __builtin_ctzll(board->getPieceBitmap(strongSide == WHITE ? WHITE_PAWN : BLACK_PAWN));
+        int i = pawn / 8, j = 7 - pawn % 8;
+        int promotionSquare = (strongSide == WHITE) ? 7 - j : 56 + 7 - j;
+
+        //Rule of the square: the pawn can't be caught if the weak king needs more moves than the pawn to reach the promotion square, counting the double step, who moves first and the capture of the new queen
+        //      Rule of the Square: [https://www.chessprogramming.org/Rule_of_the_Square]
+        int pawnMoves = (strongSide == WHITE) ? i : 7 - i;
+        if (pawnMoves == 6) --pawnMoves;
+        int weakKingMoves = squareDistance(weakKing, promotionSquare) - (board->getMoveTurn() == weakSide ? 1 : 0);
+        bool kingInTheWay = strongKing % 8 == pawn % 8 && (strongSide == WHITE ? strongKing < pawn : strongKing > pawn);
+
+        if (weakKingMoves > pawnMoves && !kingInTheWay) score = strongMaterial + KNOWN_WIN_BONUS;
+        else if ((j == 0 || j == 7) && squareDistance(weakKing, promotionSquare) <= 1) score = 0; //The rook pawn can't be promoted against the king in its corner
+        else return false;
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    evaluation = (board->getMoveTurn() == strongSide) ? score : -score;
+    return true;
+}
+
+int EngineV1::endgameScaleFactor(const MaterialTable::materialTableEntry& material, PieceColor strongSide) {
+    int scaleFactor = material.scaleFactor[strongSide];
+    if (material.endgame == MaterialTable::BISHOPS_ENDGAME) {
+        int whiteBishop = __builtin_ctzll(board->getPieceBitmap(WHITE_BISHOP));
+        int blackBishop = __builtin_ctzll(board->getPieceBitmap(BLACK_BISHOP));
+        if ((whiteBishop / 8 + whiteBishop % 8) % 2 != (blackBishop / 8 + blackBishop % 8) % 2)
+            scaleFactor = std::min(scaleFactor, OPPOSITE_BISHOPS_SCALE_FACTOR);
+    }
+    return scaleFactor;
+}
+
+int EngineV1::squareDistance(int square1, int square2) {
+    return std::max(std::abs(square1 / 8 - square2 / 8), std::abs(square1 % 8 - square2 % 8));
+}
+
+int EngineV1::edgeDistance(int square) {
+    int i = square / 8, j = square % 8;
+    return std::min(std::min(i, 7 - i), std::min(j, 7 - j));
+}
@@ -1,94 +1,315 @@
 #include "board.hpp"
 #include "engine_v1.hpp"
 
-EngineV1::EngineV1(std::shared_ptr<Board> myBoard, std::chrono::milliseconds timeSpan) {
-    board = myBoard;
-    moveDelay = timeSpan;
+EngineV1::EngineV1(std::shared_ptr<Board> myBoard, std::chrono::milliseconds timeSpan, bool ponder, int multiPV, std::shared_ptr<const NNUE> network) {
+    gameBoard = myBoard;
+    board = std::make_shared<Board>();
+    timeManager.setMoveTime(timeSpan);
     searchTimeExceeded = false;
+    numBoards = 0;
+    ponderEnabled = ponder;
+    pondering = false;
+    ponderStop = false;
+    this->multiPV = std::max(1, multiPV);
+    this->network = network;
+    accumulatorIndex = 0;
+    verbose = true;
+    transpositionTable.clear();
+    pawnHashTable.clear();
+    evalCache.clear();
+    materialTable.clear();
+    rootEvaluatedMoves.reserve(MAX_MOVES);
+    memset(historyTable, 0, sizeof(historyTable));
+    initLateMoveReductions();
+}
+
+EngineV1::~EngineV1() {
+    stopPondering();
 }
 
 bool EngineV1::canMove() {
     return true;
 }
 
-void EngineV1::iniTimer(std::chrono::milliseconds timeSpan) {
-    stopTimer = false;
-    auto end_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeSpan);
-    while (std::chrono::steady_clock::now() < end_time) {
-        if (stopTimer) return;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+const std::vector<EngineV1::PVLine>& EngineV1::getPVLines() const {
+    return pvLines;
+}
+
+void EngineV1::setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment) {
+    timeManager.setClock(remaining, increment);
+}
+
+void EngineV1::setSearchParameters(const SearchParameters& parameters) {
+    searchParameters = parameters;
+    initLateMoveReductions();
+}
+
+void EngineV1::setVerbose(bool verbose) {
+    this->verbose = verbose;
+}
+
+void EngineV1::printSearchInfo(const SearchResult& result) {
+    //The time used, and how much the maximum time has been exceeded
+    std::chrono::milliseconds timeUsed = timeManager.elapsed();
+    std::chrono::milliseconds overshoot = std::max(std::chrono::milliseconds(0), timeUsed - timeManager.getMaximumTime());
+
+    //Print some useful information about the search
+    if (interrupted) std::cout << "[INFO] Search interrupted" << std::endl;
+    std::cout << "[INFO] Depth reached: " << result.depth << std::endl;
+    if (result.mateColor != NONE_COLOR) {
+        int mateMoves = mateInMoves(result.bestMoveEval.eval);
+        if (result.mateColor == WHITE) 
+            std::cout << "[INFO] Evaluation: +M" << mateMoves << std::endl;
+        else 
+            std::cout << "[INFO] Evaluation: -M" << mateMoves << std::endl;
     }
-    searchTimeExceeded = true;
-    //TODO: maybe not using detach, but join. But currently it works fine.
+    else std::cout << "[INFO] Evaluation: " << result.bestMoveEval.eval << std::endl;
+    std::cout << "[INFO] Number of boards: " << numBoards << std::endl;
+    std::cout << "[INFO] Transposition hits: " << transpositionHits << std::endl;
+    if (evalCacheProbes > 0)
+        std::cout << "[INFO] Evaluation cache hits: " << evalCacheHits << " of " << evalCacheProbes << " (" << 100 * int64_t(evalCacheHits) / evalCacheProbes << "%)" << std::endl;
+    std::cout << "[INFO] Lazy evaluation cutoffs: " << lazyEvalCutoffs << std::endl;
+    if (pawnHashProbes > 0)
+        std::cout << "[INFO] Pawn hash hits: " << pawnHashHits << " of " << pawnHashProbes << " (" << 100 * int64_t(pawnHashHits) / pawnHashProbes << "%)" << std::endl;
+    std::cout << "[INFO] Time used: " << timeUsed.count() << " ms (optimum: " << timeManager.getOptimumTime().count() << " ms, maximum: " << timeManager.getMaximumTime().count() << " ms, overshoot: " << overshoot.count() << " ms)" << std::endl;
+
+    std::cout << "[INFO] Principal variation: " << pvToString(result.lines.front().pv) << std::endl;
+    if (result.lines.size() > 1)
+        for (int i = 0; i < result.lines.size(); ++i)
+            std::cout << "[INFO] Line " << i + 1 << ", evaluation: " << scoreToString(result.lines[i].eval) << ", PV: " << pvToString(result.lines[i].pv) << std::endl;
+}
+
+void EngineV1::checkTime() {
+    //While pondering there is no time limit, the search only stops if it's cancelled
+    if (pondering) {
+        if (ponderStop) searchTimeExceeded = true;
+        return;
+    }
+    if (timeManager.hardLimitReached()) searchTimeExceeded = true;
 }
 
 PieceMove EngineV1::getMove() {
+    //An interruption during the opponent's turn only affects the ponder search
+    bool ponderInterrupted = interrupted;
     interrupted = false;
+
+    //If the opponent hasn't made the expected reply, the ponder search is cancelled before the clock is started, so the time manager isn't used by two threads
+    bool pondered = ponderThread.joinable();
+    bool ponderHit = pondered && !ponderInterrupted && gameBoard->getZobristHash() == ponderHash;
+    if (!ponderHit) stopPondering();
+
+    //Starts the clock, the search will check it periodically
+    timeManager.start(gameBoard->getCurrentLegalMoves().size());
+
+    //On a ponder hit, the ponder search goes on under the time budget that has just been started. Its thread only reads the time manager once pondering is cleared, after the clock is started
+    if (ponderHit) {
+        pondering = false;
+        ponderThread.join();
+    }
+    if (pondered && verbose) std::cout << (ponderHit ? "[INFO] Ponder hit" : "[INFO] Ponder miss") << std::endl;
+
+    SearchResult result;
+    if (ponderHit) result = ponderResult;
+    else {
+        pondering = false;
+        *board = *gameBoard;
+        result = iterativeDeepening();
+    }
+
+    if (verbose) printSearchInfo(result);
+    pvLines = result.lines;
     
-    //Activate timer
-    std::thread timerThread(&EngineV1::iniTimer, this, moveDelay);
+    if (ponderEnabled && !interrupted) startPondering(result.lines.front().pv);
 
-    PieceColor mateColor = NONE_COLOR;
+    return result.bestMoveEval.move;
+}
 
-    //Clear the transposition table before starting the search
-    transpositionTable.clear();
+void EngineV1::startPondering(const std::vector<PieceMove>& pv) {
+    //The board after the engine's move
+    *board = *gameBoard;
+    PieceMove move = pv.front();
+    board->movePiece(move);
+    if (board->getBoardResult() != PLAYING) return;
+
+    //The expected reply is the next move of the principal variation, or the best move stored in the transposition table for that board
+    PieceMove reply = invalidMove;
+    if (pv.size() >= 2) reply = pv[1];
+    else {
+        const TranspositionTable::transTableEntry* entry = transpositionTable.getEntry(board->getZobristHash());
+        if (entry->zobristHash == board->getZobristHash()) reply = decodeMove(entry->bestMove);
+    }
+    if (board->getCurrentLegalMoves().count(reply) == 0) return;
+
+    board->movePiece(reply);
+    if (board->getBoardResult() != PLAYING) return;
+
+    if (verbose) std::cout << "[INFO] Pondering on " << reply.toString() << std::endl;
+    ponderHash = board->getZobristHash();
+    pondering = true;
+    ponderStop = false;
+    ponderThread = std::thread([this]() { ponderResult = iterativeDeepening(); });
+}
+
+void EngineV1::stopPondering() {
+    if (!ponderThread.joinable()) return;
+    ponderStop = true;
+    ponderThread.join();
+}
+
+EngineV1::SearchResult EngineV1::iterativeDeepening() {
+    searchTimeExceeded = false;
+
+    PieceColor mateColor = NONE_COLOR;
 
     numBoards = 0;
     transpositionHits = 0;
-    searchTimeExceeded = false;
+    pawnHashProbes = 0;
+    pawnHashHits = 0;
+    evalCacheProbes = 0;
+    evalCacheHits = 0;
+    lazyEvalCutoffs = 0;
+
+    resetMoveOrdering();
+    transpositionTable.newSearch();
 
-    std::set <PieceMove> legalMoves = board->getCurrentLegalMoves();
-    std::vector<PieceMove> orderedMoves(legalMoves.begin(), legalMoves.end());
+    //The accumulator of the root, the search updates the rest
+    accumulatorIndex = 0;
+    if (network) network->refresh(*board, accumulatorStack[0]);
+
+    //The first iteration will search the moves with the move ordering heuristics, the following ones by the results of the previous iteration
+    ScoredMove* rootMoves = searchStack[0].moves;
+    int rootMoveCount = orderMoves(board->getCurrentLegalMoves(), rootMoves, 0, invalidMove);
+    std::vector<PieceMove> orderedMoves;
+    for (int i = 0; i < rootMoveCount; ++i) orderedMoves.push_back(pickNextMove(rootMoves, rootMoveCount, i));
     
     MoveEval bestMoveEval = {orderedMoves[0], -INF};
-
+    std::vector<PieceMove> bestPV = {orderedMoves[0]};
+    std::vector<PVLine> lines; //The lines of the last completed iteration
+    int lineCount = std::min(multiPV, rootMoveCount);
+    previousPVLength = 0;
     
     int depth;
     for (depth = 1; depth <= MAX_DEPTH; depth++) {
-        std::vector<MoveEval> actItEvaluatedMoves = firstSearch(orderedMoves, depth);
+        std::vector<PVLine> iterationLines;
+        std::vector<MoveEval>& actItEvaluatedMoves = rootEvaluatedMoves; //Filled by each root search
+        //The best move of the iteration, kept in case the search is stopped before the first line finishes
+        bool partialResult = false;
+        MoveEval partialMoveEval;
+        std::vector<PieceMove> partialPV;
+        for (int line = 0; line < lineCount; ++line) {
+            //The moves of the lines already found are excluded, the best of the rest is the next line
+            std::vector<PieceMove> lineMoves;
+            for (PieceMove m : orderedMoves)
+                if (std::none_of(iterationLines.begin(), iterationLines.end(), [&m](const PVLine& l) { return l.move == m; })) lineMoves.push_back(m);
 
-        //If the search has examinated at least one move
-        if (!actItEvaluatedMoves.empty()) {
-            //Sort the moves based on the evaluation, from worst to best. In the bext iteration, the moves will be examined in this order
-            std::sort(actItEvaluatedMoves.begin(), actItEvaluatedMoves.end(), std::greater<MoveEval>());
-            bestMoveEval = actItEvaluatedMoves.front();
+            //Aspiration windows: the first iterations, and the ones after a mate has been found, use the whole window. The rest start with a narrow window around the previous score of the line
+            int previousEval = line == 0 ? bestMoveEval.eval : (line < lines.size() ? lines[line].eval : -INF);
+            int window = searchParameters.aspirationWindow;
+            bool fullWindow = depth <= 2 || previousEval <= -INF || isMateScore(previousEval);
+            int alpha = fullWindow ? -INF : previousEval - window;
+            int beta = fullWindow ? INF : previousEval + window;
+
+            while (true) {
+                firstSearch(lineMoves, depth, alpha, beta);
+
+                //Sort the moves based on the evaluation, from best to worst. In the next iteration, the moves will be examined in this order
+                std::stable_sort(actItEvaluatedMoves.begin(), actItEvaluatedMoves.end(), std::greater<MoveEval>());
+
+                //A move that has been completely searched with a score above alpha is better than the previous best move. It's also the case of a move that failed high, even if the search with the widened window doesn't finish
+                if (line == 0 && !actItEvaluatedMoves.empty() && actItEvaluatedMoves.front().eval > alpha) {
+                    partialResult = true;
+                    partialMoveEval = actItEvaluatedMoves.front();
+                    partialPV = getRootPV();
+                }
+                if (searchTimeExceeded || interrupted) break;
+
+                //The search is done if the score is inside the window, or if the window was already unbounded on the side that failed
+                int score = actItEvaluatedMoves.front().eval;
+                if ((score > alpha || alpha <= -INF) && (score < beta || beta >= INF)) break;
+
+                //The score is out of the window, it has to be widened on the side that failed. Once the window is too big, the whole window is used
+                window += window / 2;
+                if (score <= alpha) alpha = (window > ASPIRATION_MAX_WINDOW) ? -INF : std::max(-INF, score - window);
+                else {
+                    beta = (window > ASPIRATION_MAX_WINDOW) ? INF : std::min(INF, score + window);
+                    //The move that failed high will be the first one to be searched again
+                    PieceMove failHighMove = actItEvaluatedMoves.front().move;
+                    std::vector<PieceMove> reordered = {failHighMove};
+                    for (PieceMove m : lineMoves) 
+                        if (m != failHighMove) reordered.push_back(m);
+                    lineMoves = reordered;
+                }
+            }
+            if (searchTimeExceeded || interrupted) break;
+
+            //The principal variation of the line always starts with its move, if it couldn't be collected it's the only move of the line
+            MoveEval lineBest = actItEvaluatedMoves.front();
+            std::vector<PieceMove> linePV = getRootPV();
+            if (linePV.empty() || linePV.front() != lineBest.move) linePV = {lineBest.move};
+            iterationLines.push_back({lineBest.move, lineBest.eval, linePV});
+        }
+
+        //With several lines, their evaluations are only comparable if all of them come from the same depth, so the lines of an unfinished iteration are discarded unless none has been completed yet
+        bool iterationFinished = iterationLines.size() == lineCount;
+        if (!iterationFinished && lineCount > 1 && !lines.empty()) {
+            iterationLines.clear();
+            partialResult = false;
         }
+        //Each line is searched on its own, and a later line may get a better score than an earlier one, so the lines are ranked by their evaluation
+        std::stable_sort(iterationLines.begin(), iterationLines.end(), [](const PVLine& a, const PVLine& b) { return a.eval > b.eval; });
+
+        //When the search has been stopped before the first line finishes, the partial result is only used if a move has proven to be better than alpha, otherwise the result of the previous iteration is kept
+        if (!iterationLines.empty()) {
+            bestMoveEval = {iterationLines.front().move, iterationLines.front().eval};
+            bestPV = iterationLines.front().pv;
+        }
+        else if (partialResult) {
+            bestMoveEval = partialMoveEval;
+            bestPV = partialPV;
+        }
+        //The principal variation always starts with the best move, if it couldn't be collected it's the only move of the line
+        if (bestPV.empty() || bestPV.front() != bestMoveEval.move) bestPV = {bestMoveEval.move};
+
+        //If a checkmate is detected, the side that mates is known, also when it has been found by a partial iteration
+        if (isMateScore(bestMoveEval.eval)) {
+            if (bestMoveEval.eval > 0) mateColor = board->getMoveTurn();
+            else mateColor = board->getMoveTurn() == WHITE ? BLACK : WHITE;
+        }
+        else mateColor = NONE_COLOR;
 
         //If the time limit is exceeded, the search will stop
         if (searchTimeExceeded) break;
         if (interrupted) break;
+        lines = iterationLines;
         
-        //Reorder the moves for the next iteration based on the current evaluation, orderedMoves will have moves evaluated in the last iteration ordered from best to worst
+        if (!pondering)
+            for (int i = 0; i < lines.size(); ++i)
+                if (verbose) std::cout << "[INFO] Depth " << depth << (lineCount > 1 ? ", line " + std::to_string(i + 1) : "") << ", evaluation: " << scoreToString(lines[i].eval) << ", PV: " << pvToString(lines[i].pv) << std::endl;
+
+        //Reorder the moves for the next iteration: first the lines found, from best to worst, then the rest of the moves ordered by the evaluation of the last line search
         orderedMoves.clear();
-        for (MoveEval m : actItEvaluatedMoves) orderedMoves.push_back(m.move);
+        for (const PVLine& l : lines) orderedMoves.push_back(l.move);
+        for (MoveEval m : actItEvaluatedMoves)
+            if (std::none_of(lines.begin(), lines.end(), [&m](const PVLine& l) { return l.move == m.move; })) orderedMoves.push_back(m.move);
 
-        //If a checkmate is detected, the search will stop
-        if (bestMoveEval.eval >= INF || bestMoveEval.eval <= -INF){
-            if (bestMoveEval.eval >= INF) mateColor = board->getMoveTurn();
-            else mateColor = board->getMoveTurn() == WHITE ? BLACK : WHITE;
-            break;
+        //The principal variation will be searched first in the next iteration
+        std::copy(bestPV.begin(), bestPV.end(), previousPV);
+        previousPVLength = bestPV.size();
+
+        //Once a checkmate is detected, the search only stops when the depth covers the whole mating line, a deeper search can't find a shorter mate
+        if (isMateScore(bestMoveEval.eval) && depth >= MATE - std::abs(bestMoveEval.eval)) break;
+
+        //Depending on the stability of the search, a new iteration may not be worth it. While pondering, the time manager is not used
+        if (!pondering) {
+            timeManager.iterationFinished(bestMoveEval.move, bestMoveEval.eval);
+            if (timeManager.softLimitReached()) break;
         }
     }
 
-    //TODO: not throwing all the current iteration info
+    //The best line is the final one, the rest are the ones of the last completed iteration, which is also the one of the best line when there are several lines
+    std::vector<PVLine> resultLines = {{bestMoveEval.move, bestMoveEval.eval, bestPV}};
+    for (const PVLine& l : lines)
+        if (resultLines.size() < lineCount && l.move != bestMoveEval.move) resultLines.push_back(l);
 
-    //Stop the timer and join the thread
-    stopTimer = true;
-    if (timerThread.joinable()) timerThread.join();
-    
-    //Print some useful information about the search
-    if (interrupted) std::cout << "[INFO] Search interrupted" << std::endl;
-    std::cout << "[INFO] Depth reached: " << depth << std::endl;
-    if (mateColor != NONE_COLOR) {
-        int mateDepth = (depth+1)/2;
-        if (mateColor == WHITE) 
-            std::cout << "[INFO] Evaluation: +M" << mateDepth << std::endl;
-        else 
-            std::cout << "[INFO] Evaluation: -M" << mateDepth << std::endl;
-    }
-    else std::cout << "[INFO] Evaluation: " << bestMoveEval.eval << std::endl;
-    std::cout << "[INFO] Number of boards: " << numBoards << std::endl;
-    std::cout << "[INFO] Transposition hits: " << transpositionHits << std::endl;
-    
-    return bestMoveEval.move;
-}
\ No newline at end of file
+    return {bestMoveEval, depth, mateColor, resultLines};
+}
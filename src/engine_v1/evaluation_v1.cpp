@@ -1,91 +1,208 @@
 #include "engine_v1.hpp"
 #include "board.hpp"
 
-int EngineV1::evaluate() {
-    int whiteEval = countMaterial(WHITE);
-    int blackEval = countMaterial(BLACK);
+int EngineV1::evaluate(int alpha, int beta) {
+    int evaluation;
+    ++evalCacheProbes;
+    if (evalCache.probe(board->getZobristHash(), evaluation)) {
+        ++evalCacheHits;
+        return evaluation;
+    }
+
+    //Lazy evaluation, the network has no cheap stage, and the recognised endgames are far from their material
+    const MaterialTable::materialTableEntry* material = network ? nullptr : probeMaterial();
+    if (material && material->endgame == MaterialTable::NO_ENDGAME
+        && material->scaleFactor[WHITE] == MaterialTable::SCALE_FACTOR_NORMAL && material->scaleFactor[BLACK] == MaterialTable::SCALE_FACTOR_NORMAL) {
+        int lazyEvaluation = taperedEvaluation(board->getPieceSquareScore());
+        if (lazyEvaluation - LAZY_EVAL_MARGIN >= beta) {
+            ++lazyEvalCutoffs;
+            return lazyEvaluation - LAZY_EVAL_MARGIN;
+        }
+        if (lazyEvaluation + LAZY_EVAL_MARGIN <= alpha) {
+            ++lazyEvalCutoffs;
+            return lazyEvaluation + LAZY_EVAL_MARGIN;
+        }
+    }
+
+    evaluation = calculateEvaluation();
+    evalCache.store(board->getZobristHash(), evaluation);
+    return evaluation;
+}
+
+int EngineV1::staticEvaluation() {
+    *board = *gameBoard;
+    accumulatorIndex = 0;
+    if (network) network->refresh(*board, accumulatorStack[accumulatorIndex]);
+    return calculateEvaluation();
+}
+
+bool EngineV1::taperedStaticEvaluation() {
+    if (network) return false;
+    *board = *gameBoard;
+    const MaterialTable::materialTableEntry* material = probeMaterial();
+    return material->endgame == MaterialTable::NO_ENDGAME
+        && material->scaleFactor[WHITE] == MaterialTable::SCALE_FACTOR_NORMAL && material->scaleFactor[BLACK] == MaterialTable::SCALE_FACTOR_NORMAL;
+}
 
-    float whiteEndGamePhase = currentEndGamePhaseWeight(WHITE);
-    float blackEndGamePhase = currentEndGamePhaseWeight(BLACK);
+int EngineV1::calculateEvaluation() {
+    if (network) return network->evaluate(accumulatorStack[accumulatorIndex], board->getMoveTurn());
 
-    int whitePositionalValue = countPositionalValue(WHITE, whiteEndGamePhase);
-    int blackPositionalValue = countPositionalValue(BLACK, blackEndGamePhase);
+    const MaterialTable::materialTableEntry* material = probeMaterial();
+    int evaluation;
+    if (material->endgame != MaterialTable::NO_ENDGAME && evaluateEndgame(*material, evaluation)) return evaluation;
 
-    int evaluation = whiteEval - blackEval + whitePositionalValue - blackPositionalValue;
+    PackedScore score = board->getPieceSquareScore() + material->imbalance + positionalScore();
+
+    //The endgame score is scaled down when the side ahead will hardly win
+    int scaleFactor = endgameScaleFactor(*material, endgameValue(score) > 0 ? WHITE : BLACK);
+    if (scaleFactor != MaterialTable::SCALE_FACTOR_NORMAL)
+        score = makeScore(midgameValue(score), endgameValue(score) * scaleFactor / MaterialTable::SCALE_FACTOR_NORMAL);
+    return taperedEvaluation(score);
+}
+
+int EngineV1::taperedEvaluation(PackedScore score) {
+    //The midgame and endgame scores are blended by the game phase, with promotions it can be above the maximum
+    int phase = std::min(board->getPhase(), PieceSquareTables::MAX_PHASE);
+    int evaluation = (midgameValue(score) * phase + endgameValue(score) * (PieceSquareTables::MAX_PHASE - phase)) / PieceSquareTables::MAX_PHASE;
 
     int perspective = (board->getMoveTurn() == WHITE) ? 1 : -1;
     return evaluation * perspective;
 }
 
-float EngineV1::currentEndGamePhaseWeight(PieceColor myColor) {
-    //Based on heuristics: the less major pieces, the more endgame it is, we exclude the pawns. We will consider the endgame when the material is less than endgameMaterialStart (2 Rooks + Knight + Bishop)
-    const float multiplier = 1.0f / static_cast<float>(endgameMaterialStart);
-    int materialWithoutPawns = countMaterial(myColor) - board->getPawnsCount(myColor) * PAWN_VALUE;
-    return 1.0f - std::min(1.0f, multiplier * materialWithoutPawns);
+PackedScore EngineV1::positionalScore() {
+    return evaluatePawns() + pieceActivityScore();
+}
+
+PackedScore EngineV1::evaluatePawns() {
+    uint64_t whitePawns = board->getPieceBitmap(WHITE_PAWN);
+    uint64_t blackPawns = board->getPieceBitmap(BLACK_PAWN);
+
+    ++pawnHashProbes;
+    PawnHashTable::pawnTableEntry* entry = pawnHashTable.getEntry(board->getPawnHash());
+    if (entry->pawnHash == board->getPawnHash()) ++pawnHashHits;
+    else *entry = {board->getPawnHash(), pawnStructureScore(whitePawns, blackPawns)};
+
+    return entry->score
+         + pawnShieldScore(board->getPieceBitmap(WHITE_KING), whitePawns, WHITE)
+         - pawnShieldScore(board->getPieceBitmap(BLACK_KING), blackPawns, BLACK);
 }
 
-int EngineV1::countPositionalValue(PieceColor myColor, float myEndGamePhase) {
-    int positionalValue = 0;
-    PieceMatrix pm = board->getPieceMatrix();
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            PieceType p = pm[i][j];
-
-            //If the piece is not mine, we continue
-            if (p == NONE || pieceColor(p) != myColor) continue;
-
-            switch (p) {
-                case WHITE_PAWN:
-                    positionalValue += pawnEvals[i][j];
-                    break;
-                case BLACK_PAWN:
-                    positionalValue -= pawnEvals[7-i][7-j];
-                    break;
-                case WHITE_KNIGHT:
-                    positionalValue += knightEvals[i][j];
-                    break;
-                case BLACK_KNIGHT:
-                    positionalValue -= knightEvals[7-i][7-j];
-                    break;
-                case WHITE_BISHOP:
-                    positionalValue += bishopEvals[i][j];
-                    break;
-                case BLACK_BISHOP:
-                    positionalValue -= bishopEvals[7-i][7-j];
-                    break;
-                case WHITE_ROOK:
-                    positionalValue += rookEvals[i][j];
-                    break;
-                case BLACK_ROOK:
-                    positionalValue -= rookEvals[7-i][7-j];
-                    break;
-                case WHITE_QUEEN:
-                    positionalValue += queenEvals[i][j];
-                    break;
-                case BLACK_QUEEN:
-                    positionalValue -= queenEvals[7-i][7-j];
-                    break;
-                case WHITE_KING:
-                    positionalValue += kingEvalsMidGame[i][j]*(1.0f-myEndGamePhase) + kingEvalsEndGame[i][j]*myEndGamePhase;
-                    break;
-                case BLACK_KING:
-                    positionalValue -= kingEvalsMidGame[7-i][7-j]*(1.0f-myEndGamePhase) + kingEvalsEndGame[7-i][7-j]*myEndGamePhase;
-                    break;
-                default:
-                    break;
+PackedScore EngineV1::pawnStructureScore(uint64_t whitePawns, uint64_t blackPawns) {
+    PackedScore score = 0;
+
+    //The squares attacked by the pawns
+    uint64_t whiteAttacks = Attacks::pawns(whitePawns, WHITE);
+    uint64_t blackAttacks = Attacks::pawns(blackPawns, BLACK);
+
+    for (int color = WHITE; color <= BLACK; ++color) {
+        bool white = color == WHITE;
+        uint64_t myPawns = white ? whitePawns : blackPawns;
+        uint64_t opponentPawns = white ? blackPawns : whitePawns;
+        uint64_t opponentAttacks = white ? blackAttacks : whiteAttacks;
+        PackedScore myScore = 0;
+
+        for (int j = 0; j < 8; ++j) {
+            uint64_t file = FILE_A >> j;
+            int pawnsInFile = __builtin_popcountll(myPawns & file);
+            if (pawnsInFile > 1) myScore += DOUBLED_PAWN_PENALTY * (pawnsInFile - 1);
+        }
+
+        for (uint64_t pawns = myPawns; pawns; pawns &= pawns - 1) {
+            int square = __builtin_ctzll(pawns);
+            int i = square / 8, j = 7 - square % 8;
+            uint64_t file = FILE_A >> j;
+            uint64_t adjacentFiles = ((file & ~FILE_A) << 1) | ((file & ~FILE_H) >> 1);
+
+            //The ranks in front of the pawn, and the ones of the pawn and behind it
+            uint64_t ahead = white ? (uint64_t(1) << (8 * i)) - 1 : ~((uint64_t(2) << (8 * i + 7)) - 1);
+            uint64_t notAhead = ~ahead;
+
+            if ((opponentPawns & (file | adjacentFiles) & ahead) == 0) myScore += PASSED_PAWN_BONUS[white ? 7 - i : i];
+
+            if ((myPawns & adjacentFiles) == 0) myScore += ISOLATED_PAWN_PENALTY;
+            else if ((myPawns & adjacentFiles & notAhead) == 0) {
+                //No pawn can support it, it's backward if the square in front of it is attacked by an opponent pawn
+                uint64_t stopSquare = white ? (uint64_t(1) << square) >> 8 : (uint64_t(1) << square) << 8;
+                if (stopSquare & opponentAttacks) myScore += BACKWARD_PAWN_PENALTY;
             }
         }
+
+        score += white ? myScore : -myScore;
     }
+    return score;
+}
 
-    return positionalValue;
+PackedScore EngineV1::pawnShieldScore(uint64_t king, uint64_t pawns, PieceColor col) {
+    uint64_t front = (col == WHITE) ? king >> 8 : king << 8;
+    uint64_t closeShield = front | ((front & ~FILE_A) << 1) | ((front & ~FILE_H) >> 1);
+    uint64_t farShield = (col == WHITE) ? closeShield >> 8 : closeShield << 8;
+    return PAWN_SHIELD_CLOSE_BONUS * __builtin_popcountll(pawns & closeShield)
+         + PAWN_SHIELD_FAR_BONUS * __builtin_popcountll(pawns & farShield);
 }
 
-int EngineV1::countMaterial(PieceColor myColor) {
-    int material = 0;
-    material += board->getPawnsCount(myColor) * PAWN_VALUE;
-    material += board->getBishopsCount(myColor) * BISHOP_VALUE;
-    material += board->getKnightsCount(myColor) * KNIGHT_VALUE;
-    material += board->getRooksCount(myColor) * ROOK_VALUE;
-    material += board->getQueensCount(myColor) * QUEEN_VALUE;
-    return material;
-}
\ No newline at end of file
+PackedScore EngineV1::pieceActivityScore() {
+    //The pieces of each color, indexed by the PieceType of the white pieces
+    uint64_t pieces[2][6];
+    uint64_t colorPieces[2] = {0, 0};
+    for (int pt = WHITE_PAWN; pt <= BLACK_KING; ++pt) {
+        pieces[pt / 6][pt % 6] = board->getPieceBitmap(PieceType(pt));
+        colorPieces[pt / 6] |= pieces[pt / 6][pt % 6];
+    }
+    uint64_t occupied = colorPieces[WHITE] | colorPieces[BLACK];
+    int kingSquares[2] = {__builtin_ctzll(pieces[WHITE][WHITE_KING]), __builtin_ctzll(pieces[BLACK][WHITE_KING])};
+
+    //The squares attacked by each color, by each type of piece
+    uint64_t attackedBy[2][6];
+    for (int color = WHITE; color <= BLACK; ++color) {
+        attackedBy[color][WHITE_PAWN] = Attacks::pawns(pieces[color][WHITE_PAWN], PieceColor(color));
+        attackedBy[color][WHITE_KING] = Attacks::king(kingSquares[color]);
+    }
+
+    PackedScore scores[2] = {0, 0};
+    for (int color = WHITE; color <= BLACK; ++color) {
+        int opponent = (color == WHITE) ? BLACK : WHITE;
+        uint64_t mobilityArea = ~colorPieces[color] & ~attackedBy[opponent][WHITE_PAWN];
+        uint64_t kingZone = attackedBy[opponent][WHITE_KING] | pieces[opponent][WHITE_KING];
+        int kingAttackers = 0;
+        PackedScore kingAttack = 0;
+
+        for (int pt = WHITE_BISHOP; pt <= WHITE_QUEEN; ++pt) {
+            attackedBy[color][pt] = 0;
+            for (uint64_t bits = pieces[color][pt]; bits; bits &= bits - 1) {
+                int square = __builtin_ctzll(bits);
+                uint64_t attacks;
+                if (pt == WHITE_KNIGHT) attacks = Attacks::knight(square);
+                else if (pt == WHITE_BISHOP) attacks = Attacks::bishop(square, occupied);
+                else if (pt == WHITE_ROOK) attacks = Attacks::rook(square, occupied);
+                else attacks = Attacks::queen(square, occupied);
+                attackedBy[color][pt] |= attacks;
+
+                scores[color] += MOBILITY_BONUS[pt] * __builtin_popcountll(attacks & mobilityArea);
+                if (attacks & kingZone) {
+                    ++kingAttackers;
+                    kingAttack += KING_ZONE_ATTACK_BONUS[pt] * __builtin_popcountll(attacks & kingZone);
+                }
+            }
+        }
+        if (kingAttackers >= KING_ATTACKERS_MIN) scores[color] += kingAttack;
+    }
+
+    //Safe checks: the squares from where a type of piece would check the opponent's king, attacked by a piece of that type and not by the opponent
+    for (int color = WHITE; color <= BLACK; ++color) {
+        int opponent = (color == WHITE) ? BLACK : WHITE;
+        uint64_t opponentAttacks = 0;
+        for (int pt = WHITE_PAWN; pt <= WHITE_KING; ++pt) opponentAttacks |= attackedBy[opponent][pt];
+        uint64_t safe = ~opponentAttacks & ~colorPieces[color];
+
+        int kingSquare = kingSquares[opponent];
+        uint64_t knightChecks = Attacks::knight(kingSquare);
+        uint64_t bishopChecks = Attacks::bishop(kingSquare, occupied);
+        uint64_t rookChecks = Attacks::rook(kingSquare, occupied);
+        scores[color] += SAFE_CHECK_BONUS[WHITE_KNIGHT] * __builtin_popcountll(knightChecks & attackedBy[color][WHITE_KNIGHT] & safe);
+        scores[color] += SAFE_CHECK_BONUS[WHITE_BISHOP] * __builtin_popcountll(bishopChecks & attackedBy[color][WHITE_BISHOP] & safe);
+        scores[color] += SAFE_CHECK_BONUS[WHITE_ROOK] * __builtin_popcountll(rookChecks & attackedBy[color][WHITE_ROOK] & safe);
+        scores[color] += SAFE_CHECK_BONUS[WHITE_QUEEN] * __builtin_popcountll((bishopChecks | rookChecks) & attackedBy[color][WHITE_QUEEN] & safe);
+    }
+
+    return scores[WHITE] - scores[BLACK];
+}
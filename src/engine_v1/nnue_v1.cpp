@@ -0,0 +1,148 @@
+#include "nnue.hpp"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+//  Reads count little-endian int16_t values from the file, returns false if there are not enough
+static bool readValues(std::ifstream& file, int16_t* values, int count) {
+    std::vector<unsigned char> bytes(2 * count);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), bytes.size())) return false;
+    for (int i = 0; i < count; ++i)
+        values[i] = int16_t(uint16_t(bytes[2 * i]) | uint16_t(bytes[2 * i + 1]) << 8);
+    return true;
+}
+
+//  Adds or subtracts the weights of a feature to the accumulator of a perspective
+static void addWeights(int16_t* accumulator, const int16_t* weights) {
+#if defined(__AVX2__)
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_add_epi16(a, w));
+    }
+#elif defined(__SSE4_1__)
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_add_epi16(a, w));
+    }
+#else
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; ++i) accumulator[i] += weights[i];
+#endif
+}
+
+static void subtractWeights(int16_t* accumulator, const int16_t* weights) {
+#if defined(__AVX2__)
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_sub_epi16(a, w));
+    }
+#elif defined(__SSE4_1__)
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_sub_epi16(a, w));
+    }
+#else
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; ++i) accumulator[i] -= weights[i];
+#endif
+}
+
+//  Returns the dot product of the accumulator of a perspective, activated by the clipped ReLU, and the output weights
+static int activatedDot(const int16_t* accumulator, const int16_t* weights) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(NNUE::QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), qa);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, w));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4e));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xb1));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(__SSE4_1__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa = _mm_set1_epi16(NNUE::QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        a = _mm_min_epi16(_mm_max_epi16(a, zero), qa);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a, w));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; ++i)
+        sum += std::clamp(int(accumulator[i]), 0, NNUE::QA) * weights[i];
+    return sum;
+#endif
+}
+
+bool NNUE::load(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) return false;
+
+    std::unique_ptr<Weights> loaded = std::make_unique<Weights>();
+    if (!readValues(file, &loaded->featureWeights[0][0], INPUT_SIZE * HIDDEN_SIZE)) return false;
+    if (!readValues(file, loaded->featureBiases, HIDDEN_SIZE)) return false;
+    if (!readValues(file, loaded->outputWeights, 2 * HIDDEN_SIZE)) return false;
+    if (!readValues(file, &loaded->outputBias, 1)) return false;
+
+    //The file has to end here, otherwise it's a different network
+    if (file.peek() != std::ifstream::traits_type::eof()) return false;
+
+    weights = std::move(loaded);
+    return true;
+}
+
+int NNUE::featureIndex(PieceColor perspective, PieceType pt, int square) {
+    //The bit of the square (i, j) is 8*i + 7 - j, being i = 0 the 8th rank
+    int i = square / 8, j = 7 - square % 8;
+    int relativeSquare = (7 - i) * 8 + j;
+    if (perspective == BLACK) relativeSquare ^= 56;
+    int side = pieceColor(pt) == perspective ? 0 : 1;
+    return side * 384 + INPUT_PIECE_INDEX[pt] * 64 + relativeSquare;
+}
+
+void NNUE::refresh(const Board& board, Accumulator& accumulator) const {
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective)
+        std::copy(weights->featureBiases, weights->featureBiases + HIDDEN_SIZE, accumulator.values[perspective]);
+
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            PieceType pt = board.getPieceType(i, j);
+            if (pt == NONE) continue;
+            int square = 8 * i + 7 - j;
+            for (int perspective = WHITE; perspective <= BLACK; ++perspective)
+                addWeights(accumulator.values[perspective], weights->featureWeights[featureIndex(PieceColor(perspective), pt, square)]);
+        }
+    }
+}
+
+void NNUE::update(const Accumulator& previous, Accumulator& next, const Board::PieceChange* changes, int changesCount) const {
+    next = previous;
+    for (int k = 0; k < changesCount; ++k) {
+        const Board::PieceChange& change = changes[k];
+        for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+            const int16_t* featureWeights = weights->featureWeights[featureIndex(PieceColor(perspective), change.piece, change.square)];
+            if (change.added) addWeights(next.values[perspective], featureWeights);
+            else subtractWeights(next.values[perspective], featureWeights);
+        }
+    }
+}
+
+int NNUE::evaluate(const Accumulator& accumulator, PieceColor moveTurn) const {
+    PieceColor opponent = (moveTurn == WHITE) ? BLACK : WHITE;
+    int output = activatedDot(accumulator.values[moveTurn], weights->outputWeights)
+               + activatedDot(accumulator.values[opponent], weights->outputWeights + HIDDEN_SIZE);
+    return (output + weights->outputBias) * SCALE / (QA * QB);
+}
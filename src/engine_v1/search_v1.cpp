@@ -1,125 +1,533 @@
 #include "engine_v1.hpp"
 #include "board.hpp"
 
+#ifdef ENGINE_ALLOCATION_CHECK
+//The allocations made by each thread, and how many of them were made by the board while making and undoing moves
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t boardAllocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+//Asserts that no memory is allocated in its scope, apart from the board allocations
+struct NodeAllocationCheck {
+    uint64_t searchAllocations = allocationCount - boardAllocationCount;
+    ~NodeAllocationCheck() { assert(allocationCount - boardAllocationCount == searchAllocations && "The search allocated memory"); }
+};
+
+//Counts the allocations made in its scope as board allocations
+struct BoardAllocationScope {
+    uint64_t start = allocationCount;
+    ~BoardAllocationScope() { boardAllocationCount += allocationCount - start; }
+};
+#else
+struct NodeAllocationCheck { };
+struct BoardAllocationScope { };
+#endif
 
-std::vector<EngineV1::MoveEval> EngineV1::firstSearch(const std::vector<PieceMove>& orderedMoves, int depth) {
-    numBoards++;
 
-    std::vector<EngineV1::MoveEval> evaluatedMoves;
+void EngineV1::firstSearch(const std::vector<PieceMove>& orderedMoves, int depth, int alpha, int beta) {
+    [[maybe_unused]] NodeAllocationCheck allocationCheck;
+    if (++numBoards % TIME_CHECK_INTERVAL == 0) checkTime();
 
+    rootEvaluatedMoves.clear();
+
+    searchStack[0].pvLength = 0;
+    searchStack[0].followingPV = true;
+
+    bool firstMove = true;
     for (PieceMove move : orderedMoves) {
-        board->movePiece(move);
-        int score = -search(depth - 1, -INF, INF);
-        board->undoMove();
+        searchStack[0].playedMove = move;
+        searchStack[0].playedPiece = board->getPieceType(move.from.i, move.from.j);
+        makeMove(move);
+        int score;
+        //The first move is expected to be the best one, it is searched with the whole window. The rest are searched with a null window, only proving that they are not better than alpha. If one of them is, it will be searched again with the whole window
+        if (firstMove) score = -search<PV_NODE>(depth - 1, 1, -beta, -alpha);
+        else {
+            score = -search<NON_PV_NODE>(depth - 1, 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) score = -search<PV_NODE>(depth - 1, 1, -beta, -alpha);
+        }
+        undoMove();
+        firstMove = false;
 
-        if (searchTimeExceeded) return evaluatedMoves;
-        if (interrupted) return evaluatedMoves;
+        if (searchTimeExceeded) return;
+        if (interrupted) return;
 
-        evaluatedMoves.push_back({move, score});
-    }
+        rootEvaluatedMoves.push_back({move, score});
+        if (score > alpha) updatePV(0, move);
 
-    return evaluatedMoves;
+        //If the move fails high, the window has to be widened, there is no point in searching the rest of the moves
+        if (score >= beta) return;
+        if (score > alpha) alpha = score;
+    }
 }
 
-int EngineV1::search(int depth, int alpha, int beta) {
+template <EngineV1::SearchNodeType nodeType>
+int EngineV1::search(int depth, int ply, int alpha, int beta) {
+    constexpr bool pvNode = nodeType == PV_NODE;
+    [[maybe_unused]] NodeAllocationCheck allocationCheck;
+    SearchStack& ss = searchStack[ply];
+    //The line is cleared in every node type, a move that fails high in a null window search at the root is recorded without a line of a sibling
+    ss.pvLength = 0;
     if (interrupted || searchTimeExceeded) return 0;
 
-    numBoards++;
-    if (board->getBoardResult() == CHECKMATE) return -INF; //If i'm checkmated, my evaluation is -INF
+    if (++numBoards % TIME_CHECK_INTERVAL == 0) checkTime();
+    if (board->getBoardResult() == CHECKMATE) return -MATE + ply; //If i'm checkmated, my evaluation is -MATE, the later the better
     if (board->getBoardResult() == STALE_MATE) return 0; //If it's a stalemate, the evaluation is 0
     if (board->getBoardResult() == THREEFOLD_REPETITION) return 0; //If it's a threefold repetition, the evaluation is 0
 
-    //Transposition table handling: if the current board is already in the table, we will use the stored evaluation
+    //Mate distance pruning: even mating in the next move, the score can't be better than a shorter mate already found. Neither can it be worse than being mated right now
+    //      Mate Distance Pruning: [https://www.chessprogramming.org/Mate_Distance_Pruning]
+    alpha = std::max(alpha, -MATE + ply);
+    beta = std::min(beta, MATE - ply - 1);
+    if (alpha >= beta) return alpha;
+
+    //Transposition table handling: if the current board is already in the table, we will use the stored evaluation if it comes from this search and its bound is good enough for the current window. Otherwise its best move will be searched first. The principal variation nodes are always searched, so their line is not cut
     uint64_t currentHash = board->getZobristHash();
+    PieceMove hashMove = invalidMove;
     if (transpositionTable.contains(currentHash)) {
         auto entry = transpositionTable.getEntry(currentHash);
-        if (entry->depth >= depth) {
+        int entryScore = TranspositionTable::getScore(entry, ply);
+        if (!pvNode && entry->depth >= depth && transpositionTable.isCurrent(entry)) {
             ++transpositionHits;
             if (entry->nodeType == TranspositionTable::NT_EXACT) 
-                return entry->score;
-            else if (entry->nodeType == TranspositionTable::NT_UPPERBOUND && entry->score <= alpha) 
-                alpha = entry->score;
-            else if (entry->nodeType == TranspositionTable::NT_LOWERBOUND && entry->score >= beta)
-                beta = entry->score;
-            
-            if (alpha >= beta) return entry->score;
+                return entryScore;
+            else if (entry->nodeType == TranspositionTable::NT_UPPERBOUND && entryScore <= alpha) 
+                return entryScore;
+            else if (entry->nodeType == TranspositionTable::NT_LOWERBOUND && entryScore >= beta)
+                return entryScore;
         }
+        hashMove = decodeMove(entry->bestMove);
+    }
+
+    //While following the principal variation of the previous iteration, its move is searched first. It can only be followed through PV nodes
+    if constexpr (pvNode) {
+        ss.followingPV = searchStack[ply - 1].followingPV && ply <= previousPVLength && searchStack[ply - 1].playedMove == previousPV[ply - 1];
+        if (ss.followingPV && ply < previousPVLength) hashMove = previousPV[ply];
+    }
+
+    if (depth == 0) return quiescenceSearch(ply, alpha, beta);
+
+    bool inCheck = board->isInCheck();
+    int staticEval = inCheck ? -INF : evaluate();
+
+    //Reverse futility pruning: the static evaluation is so far above beta that the opponent won't be able to get below it
+    if (!pvNode && !inCheck && depth <= RFP_MAX_DEPTH && !isMateScore(beta) && staticEval - searchParameters.rfpMargin * depth >= beta)
+        return staticEval;
+
+    //Razoring: the static evaluation is so far below alpha that only captures could save the board, if the quiescence search confirms it, the board is pruned
+    if (!pvNode && !inCheck && depth <= RAZORING_MAX_DEPTH && !isMateScore(alpha) && staticEval + searchParameters.razoringMargin[depth] <= alpha) {
+        int score = quiescenceSearch(ply, alpha, beta);
+        if (depth == 1 || score <= alpha) return score;
     }
 
-    if (depth == 0) return quiescenceSearch(alpha, beta);
+    //Null move pruning: if I pass the turn and the opponent still can't get below beta with a reduced search, the board is good enough to be pruned. It's not done in check, after another null move, nor when I only have pawns, since zugzwang is likely
+    PieceColor turn = board->getMoveTurn();
+    bool onlyPawns = board->getPlayerPiecesCount(turn) == board->getPawnsCount(turn) + 1;
+    if (!pvNode && !inCheck && !onlyPawns && depth >= NULL_MOVE_MIN_DEPTH && searchStack[ply - 1].playedPiece != NONE && staticEval >= beta) {
+        int reduction = searchParameters.nullMoveReduction + depth / searchParameters.nullMoveDepthDivisor;
+        ss.playedMove = invalidMove;
+        ss.playedPiece = NONE;
+
+        makeNullMove();
+        int score = -search<NON_PV_NODE>(std::max(0, depth - 1 - reduction), ply + 1, -beta, -beta + 1);
+        undoNullMove();
+
+        if (interrupted || searchTimeExceeded) return 0;
+
+        //A mate found after passing is not proven, so beta is returned instead
+        if (score >= beta) return isMateScore(score) ? beta : score;
+    }
 
     int evalType = TranspositionTable::NT_UPPERBOUND;
+    int bestScore = -INF;
+    PieceMove bestMove = invalidMove;
+
+    ScoredMove* moves = ss.moves;
+    int moveCount = orderMoves(getLegalMoves(), moves, ply, hashMove);
+    ss.searchedQuietsCount = 0;
+    //After a null move, a stalemate is only detected once the legal moves are calculated
+    if (board->getBoardResult() == STALE_MATE) return 0;
 
-    std::list<PieceMove> moveList;
-    orderMoves(board->getCurrentLegalMoves(), moveList); //FIX: more accurate ordering
+    //Futility pruning: near the leaves, if the static evaluation plus a margin can't reach alpha, the quiet moves won't either
+    bool futilityPruning = !pvNode && !inCheck && depth <= FUTILITY_MAX_DEPTH && !isMateScore(alpha) && staticEval + searchParameters.futilityMargin[depth] <= alpha;
 
-    for (PieceMove m : moveList) {
-        board->movePiece(m);
-        int score = -search(depth - 1, -beta, -alpha);
-        board->undoMove();
+    int color = turn == WHITE ? 0 : 1;
+    for (int i = 0; i < moveCount; ++i) {
+        PieceMove m = pickNextMove(moves, moveCount, i);
+        bool isQuiet = !board->isCapture(m) && !board->isPromotion(m);
+        bool isRefutation = moves[i].score >= COUNTER_MOVE_SCORE; //Hash, killer or counter move
 
+        //The pruned moves count as if they had been searched with the futility value as their score. They are decided before making them, so only the searched moves are made
+        if (futilityPruning && i > 0 && isQuiet && !board->givesCheck(m)) {
+            bestScore = std::max(bestScore, staticEval + searchParameters.futilityMargin[depth]);
+            continue;
+        }
+
+        ss.playedMove = m;
+        ss.playedPiece = board->getPieceType(m.from.i, m.from.j);
+        makeMove(m);
+
+        int score;
+        //Principal Variation Search: only the first move is searched with the whole window, the rest of them with a null window, and searched again if they happen to improve alpha
+        if (i == 0) score = -search<nodeType>(depth - 1, ply + 1, -beta, -alpha);
+        else {
+            //Late Move Reductions: quiet moves searched late are expected to fail low, so they are searched with a reduced depth first. If they improve alpha, they are searched again at full depth
+            int reduction = 0;
+            if (isQuiet && !inCheck && depth >= LMR_MIN_DEPTH && i >= LMR_MIN_MOVE_NUMBER) {
+                int history = historyTable[color][m.from.i * 8 + m.from.j][m.to.i * 8 + m.to.j];
+                reduction = lateMoveReduction(depth, i, history, pvNode, board->isInCheck(), isRefutation);
+            }
+
+            score = -search<NON_PV_NODE>(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction > 0 && score > alpha) score = -search<NON_PV_NODE>(depth - 1, ply + 1, -alpha - 1, -alpha);
+            //In a non PV node the window is already null, there is nothing to search again
+            if (pvNode && score > alpha && score < beta) score = -search<PV_NODE>(depth - 1, ply + 1, -beta, -alpha);
+        }
+        undoMove();
 
         if (interrupted || searchTimeExceeded) return 0;
 
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = m;
+        }
         if (score >= beta) {
-            transpositionTable.insert(currentHash, beta, depth, TranspositionTable::NT_LOWERBOUND);
-            return beta;
+            if (isQuiet) updateQuietHeuristics(m, ply, depth);
+            transpositionTable.insert(currentHash, score, depth, TranspositionTable::NT_LOWERBOUND, ply, encodeMove(m));
+            return score;
         }
         if (score > alpha) {
             evalType = TranspositionTable::NT_EXACT;
             alpha = score;
+            if constexpr (pvNode) updatePV(ply, m);
         }
+        if (isQuiet) ss.searchedQuiets[ss.searchedQuietsCount++] = m;
     }
     
-    transpositionTable.insert(currentHash, alpha, depth, evalType);
-    return alpha;
+    //The best move is only stored if it is exact, otherwise the previous one is kept
+    transpositionTable.insert(currentHash, bestScore, depth, evalType, ply, evalType == TranspositionTable::NT_EXACT ? encodeMove(bestMove) : 0);
+    return bestScore;
 }
 
-int EngineV1::quiescenceSearch(int alpha, int beta) {
-    if (interrupted) return 0;
+int EngineV1::quiescenceSearch(int ply, int alpha, int beta) {
+    [[maybe_unused]] NodeAllocationCheck allocationCheck;
+    if (interrupted || searchTimeExceeded) return 0;
     
-    numBoards++;
-
-    int score = evaluate();
-    if (score >= beta) return beta;
-    alpha = std::max(alpha, score);
-
-    std::set<PieceMove> captureSet = {};
-    board->getCurrentTakes(captureSet);
-    if (captureSet.empty()) return score;
+    if (++numBoards % TIME_CHECK_INTERVAL == 0) checkTime();
+    if (board->getBoardResult() == CHECKMATE) return -MATE + ply;
+    if (board->getBoardResult() == STALE_MATE) return 0;
+    if (board->getBoardResult() == THREEFOLD_REPETITION) return 0;
 
+    //Transposition table handling, as in the search. Any entry is deep enough for the quiescence search
     uint64_t currentHash = board->getZobristHash();
+    PieceMove hashMove = invalidMove;
+    bool deeperEntry = false; //An entry of this board from the search is not replaced
     if (transpositionTable.contains(currentHash)) {
-        ++transpositionHits;
-        return transpositionTable.getEntry(currentHash)->score;
+        auto entry = transpositionTable.getEntry(currentHash);
+        int entryScore = TranspositionTable::getScore(entry, ply);
+        bool current = transpositionTable.isCurrent(entry);
+        if (current && (entry->nodeType == TranspositionTable::NT_EXACT ||
+           (entry->nodeType == TranspositionTable::NT_UPPERBOUND && entryScore <= alpha) ||
+           (entry->nodeType == TranspositionTable::NT_LOWERBOUND && entryScore >= beta))) {
+            ++transpositionHits;
+            return entryScore;
+        }
+        hashMove = decodeMove(entry->bestMove);
+        deeperEntry = current && entry->depth > 0;
     }
 
-    for (PieceMove capture : captureSet) {
-        board->movePiece(capture);
-        score = -quiescenceSearch(-beta, -alpha);
-        board->undoMove();
+    bool inCheck = board->isInCheck();
+    if (ply >= MAX_PLY - 1) return inCheck ? 0 : evaluate();
+
+    //Stand pat: the player doesn't have to capture, so the static evaluation is a lower bound of the score. In check there is no such option
+    int standPat = -INF;
+    int bestScore = -INF;
+    if (!inCheck) {
+        standPat = evaluate(alpha, beta);
+        if (standPat >= beta) {
+            if (!deeperEntry) transpositionTable.insert(currentHash, standPat, 0, TranspositionTable::NT_LOWERBOUND, ply);
+            return standPat;
+        }
+        bestScore = standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    int evalType = TranspositionTable::NT_UPPERBOUND;
+    PieceMove bestMove = invalidMove;
+
+    SearchStack& ss = searchStack[ply];
+    ScoredMove* moves = ss.moves;
+    int moveCount = orderQuiescenceMoves(moves, ply, hashMove, inCheck);
+    if (board->getBoardResult() == STALE_MATE) return 0;
+
+    for (int i = 0; i < moveCount; ++i) {
+        PieceMove m = pickNextMove(moves, moveCount, i);
+
+        if (!inCheck && !board->isPromotion(m)) {
+            PieceType victim = board->getPieceType(m.to.i, m.to.j);
+            int victimValue = SEE_PIECE_VALUES[victim == NONE ? WHITE_PAWN : victim];
+
+            //Delta pruning: even winning the piece, the score would be below alpha
+            if (standPat + victimValue + searchParameters.deltaMargin <= alpha) continue;
+
+            //The captures that lose material are not searched. If the victim is worth at least as much as the aggressor the capture can't lose material
+            PieceType aggressor = board->getPieceType(m.from.i, m.from.j);
+            if (victimValue < SEE_PIECE_VALUES[aggressor] && board->staticExchangeEvaluation(m, SEE_PIECE_VALUES) < 0) continue;
+        }
+
+        ss.playedMove = m;
+        ss.playedPiece = board->getPieceType(m.from.i, m.from.j);
+        makeMove(m);
+        int score = -quiescenceSearch(ply + 1, -beta, -alpha);
+        undoMove();
+
+        if (interrupted || searchTimeExceeded) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = m;
+        }
         if (score >= beta) {
-            transpositionTable.insert(currentHash, beta, 0, TranspositionTable::NT_QUIESCENCE);
-            return beta;
+            if (!deeperEntry) transpositionTable.insert(currentHash, score, 0, TranspositionTable::NT_LOWERBOUND, ply, encodeMove(m));
+            return score;
+        }
+        if (score > alpha) {
+            evalType = TranspositionTable::NT_EXACT;
+            alpha = score;
         }
-        alpha = std::max(alpha, score);
     }
 
-    transpositionTable.insert(currentHash, alpha, 0, TranspositionTable::NT_QUIESCENCE);
-    return alpha;
+    if (!deeperEntry) transpositionTable.insert(currentHash, bestScore, 0, evalType, ply, evalType == TranspositionTable::NT_EXACT ? encodeMove(bestMove) : 0);
+    return bestScore;
 }
 
-void EngineV1::orderMoves(const std::set<PieceMove>& moves, std::list<PieceMove>& orderedMoves) {
-    //The order of the moves is: promotions, captures, other, targeted
-    std::list<PieceMove> captures, promotions, targeted, other;
-    for (PieceMove move : moves) {
-        if (board->isPromotion(move)) promotions.push_back(move);
-        else if (board->isCapture(move)) captures.push_back(move);
-        else if (board->isTargeted(move)) targeted.push_back(move);
-        else other.push_back(move);
+void EngineV1::makeMove(PieceMove& move) {
+    {
+        [[maybe_unused]] BoardAllocationScope boardAllocations;
+        board->movePiece(move);
+    }
+    if (network) {
+        assert(accumulatorIndex < MAX_PLY);
+        network->update(accumulatorStack[accumulatorIndex], accumulatorStack[accumulatorIndex + 1], board->getPieceChanges(), board->getPieceChangesCount());
     }
-    orderedMoves.splice(orderedMoves.end(), promotions);
-    orderedMoves.splice(orderedMoves.end(), captures);
-    orderedMoves.splice(orderedMoves.end(), other);
-    orderedMoves.splice(orderedMoves.end(), targeted);
+    ++accumulatorIndex;
+}
+
+void EngineV1::undoMove() {
+    [[maybe_unused]] BoardAllocationScope boardAllocations;
+    board->undoMove();
+    --accumulatorIndex;
+}
+
+const std::set<PieceMove>& EngineV1::getLegalMoves() {
+    [[maybe_unused]] BoardAllocationScope boardAllocations;
+    return board->getCurrentLegalMoves();
+}
+
+void EngineV1::makeNullMove() {
+    {
+        [[maybe_unused]] BoardAllocationScope boardAllocations;
+        board->makeNullMove();
+    }
+    if (network) {
+        assert(accumulatorIndex < MAX_PLY);
+        accumulatorStack[accumulatorIndex + 1] = accumulatorStack[accumulatorIndex];
+    }
+    ++accumulatorIndex;
+}
+
+void EngineV1::undoNullMove() {
+    [[maybe_unused]] BoardAllocationScope boardAllocations;
+    board->undoNullMove();
+    --accumulatorIndex;
+}
+
+int EngineV1::orderMoves(const std::set<PieceMove>& moves, ScoredMove* buffer, int ply, const PieceMove& hashMove) {
+    int color = board->getMoveTurn() == WHITE ? 0 : 1;
+
+    //The counter move of the previous move, if there is one and it is not a null move
+    PieceMove counterMove = invalidMove;
+    if (ply > 0 && searchStack[ply - 1].playedPiece != NONE) counterMove = counterMoves[searchStack[ply - 1].playedPiece][searchStack[ply - 1].playedMove.to.i * 8 + searchStack[ply - 1].playedMove.to.j];
+
+    int moveCount = 0;
+    for (const PieceMove& move : moves) {
+        int score;
+        if (move == hashMove) 
+            score = HASH_MOVE_SCORE;
+        else if (board->isPromotion(move)) 
+            score = PROMOTION_SCORE + PIECE_ORDER_RANK[move.promoteTo];
+        else if (board->isCapture(move)) 
+            score = captureScore(move);
+        else if (move == searchStack[ply].killers[0]) 
+            score = KILLER_SCORE + 1;
+        else if (move == searchStack[ply].killers[1]) 
+            score = KILLER_SCORE;
+        else if (move == counterMove) 
+            score = COUNTER_MOVE_SCORE;
+        else {
+            score = historyTable[color][move.from.i * 8 + move.from.j][move.to.i * 8 + move.to.j];
+            if (board->isTargeted(move)) score -= TARGETED_PENALTY;
+        }
+        buffer[moveCount++] = {move, score};
+    }
+    return moveCount;
+}
+
+int EngineV1::orderQuiescenceMoves(ScoredMove* buffer, int ply, const PieceMove& hashMove, bool inCheck) {
+    if (inCheck) return orderMoves(getLegalMoves(), buffer, ply, hashMove);
+
+    int moveCount = 0;
+    for (const PieceMove& move : getLegalMoves()) {
+        bool isPromotion = board->isPromotion(move);
+        bool isCapture = board->isCapture(move);
+        //Underpromotions are only searched if they capture
+        if (isPromotion && move.promoteTo != WHITE_QUEEN && move.promoteTo != BLACK_QUEEN && !isCapture) continue;
+        if (!isPromotion && !isCapture) continue;
+
+        int score;
+        if (move == hashMove) 
+            score = HASH_MOVE_SCORE;
+        else if (isPromotion) 
+            score = PROMOTION_SCORE + PIECE_ORDER_RANK[move.promoteTo];
+        else 
+            score = captureScore(move);
+        buffer[moveCount++] = {move, score};
+    }
+    return moveCount;
+}
+
+int EngineV1::captureScore(const PieceMove& move) {
+    //Most Valuable Victim - Least Valuable Aggressor. If the captured square is empty it's an en passant capture
+    PieceType victim = board->getPieceType(move.to.i, move.to.j);
+    PieceType aggressor = board->getPieceType(move.from.i, move.from.j);
+    int victimRank = victim == NONE ? PIECE_ORDER_RANK[WHITE_PAWN] : PIECE_ORDER_RANK[victim];
+    return CAPTURE_SCORE + 8 * victimRank - PIECE_ORDER_RANK[aggressor];
+}
+
+const PieceMove& EngineV1::pickNextMove(ScoredMove* buffer, int moveCount, int index) {
+    int best = index;
+    for (int i = index + 1; i < moveCount; ++i)
+        if (buffer[i].score > buffer[best].score) best = i;
+    std::swap(buffer[index], buffer[best]);
+    return buffer[index].move;
+}
+
+void EngineV1::updateQuietHeuristics(const PieceMove& move, int ply, int depth) {
+    SearchStack& ss = searchStack[ply];
+
+    //Killer moves, the newest one is stored in the first slot
+    if (move != ss.killers[0]) {
+        ss.killers[1] = ss.killers[0];
+        ss.killers[0] = move;
+    }
+
+    //Counter move of the previous move
+    if (ply > 0 && searchStack[ply - 1].playedPiece != NONE) counterMoves[searchStack[ply - 1].playedPiece][searchStack[ply - 1].playedMove.to.i * 8 + searchStack[ply - 1].playedMove.to.j] = move;
+
+    //History: the move that produced the cutoff gets a bonus, the quiet moves searched before it a malus
+    int color = board->getMoveTurn() == WHITE ? 0 : 1;
+    int bonus = std::min(depth * depth, HISTORY_MAX / 4);
+    updateHistory(historyTable[color][move.from.i * 8 + move.from.j][move.to.i * 8 + move.to.j], bonus);
+    for (int i = 0; i < ss.searchedQuietsCount; ++i) {
+        const PieceMove& m = ss.searchedQuiets[i];
+        updateHistory(historyTable[color][m.from.i * 8 + m.from.j][m.to.i * 8 + m.to.j], -bonus);
+    }
+}
+
+void EngineV1::updateHistory(int& entry, int bonus) {
+    //History gravity: the closer the entry is to the maximum, the smaller the effect of the bonus
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+void EngineV1::resetMoveOrdering() {
+    for (int i = 0; i < MAX_PLY; ++i)
+        searchStack[i].killers[0] = searchStack[i].killers[1] = invalidMove;
+
+    //The history of the previous searches is still useful, but less reliable
+    for (int c = 0; c < 2; ++c)
+        for (int from = 0; from < 64; ++from)
+            for (int to = 0; to < 64; ++to)
+                historyTable[c][from][to] /= 2;
+}
+
+void EngineV1::updatePV(int ply, const PieceMove& move) {
+    SearchStack& ss = searchStack[ply];
+    const SearchStack& child = searchStack[ply + 1];
+    ss.pv[0] = move;
+    for (int i = 0; i < child.pvLength; ++i) ss.pv[i + 1] = child.pv[i];
+    ss.pvLength = child.pvLength + 1;
+}
+
+std::vector<PieceMove> EngineV1::getRootPV() const {
+    return std::vector<PieceMove>(searchStack[0].pv, searchStack[0].pv + searchStack[0].pvLength);
+}
+
+std::string EngineV1::pvToString(const std::vector<PieceMove>& pv) {
+    std::string str = "";
+    for (PieceMove move : pv) {
+        if (!str.empty()) str += ", ";
+        str += move.toString();
+    }
+    return str;
+}
+
+bool EngineV1::isMateScore(int score) {
+    return score >= TranspositionTable::MATE_THRESHOLD || score <= -TranspositionTable::MATE_THRESHOLD;
+}
+
+int EngineV1::mateInMoves(int score) {
+    int plies = MATE - std::abs(score);
+    return (plies + 1) / 2;
+}
+
+std::string EngineV1::scoreToString(int score) {
+    if (!isMateScore(score)) return std::to_string(score);
+    return (score > 0 ? "M" : "-M") + std::to_string(mateInMoves(score));
+}
+
+void EngineV1::initLateMoveReductions() {
+    for (int depth = 0; depth < LMR_TABLE_SIZE; ++depth) {
+        for (int moveNumber = 0; moveNumber < LMR_TABLE_SIZE; ++moveNumber) {
+            if (depth == 0 || moveNumber == 0) lmrReductions[depth][moveNumber] = 0;
+            else lmrReductions[depth][moveNumber] = int(searchParameters.lmrBase + std::log(depth) * std::log(moveNumber) / searchParameters.lmrDivisor);
+        }
+    }
+}
+
+int EngineV1::lateMoveReduction(int depth, int moveNumber, int history, bool pvNode, bool givesCheck, bool isRefutation) {
+    int reduction = lmrReductions[std::min(depth, LMR_TABLE_SIZE - 1)][std::min(moveNumber, LMR_TABLE_SIZE - 1)];
+
+    //Less reduction for the nodes in the principal variation, moves that give check and killer or counter moves
+    if (pvNode) --reduction;
+    if (givesCheck) --reduction;
+    if (isRefutation) --reduction;
+
+    //Moves with a good history are reduced less, and the ones with a bad history more
+    reduction -= history / searchParameters.lmrHistoryDivisor;
+
+    //The reduced search has at least depth 1
+    return std::clamp(reduction, 0, depth - 2);
+}
+
+uint16_t EngineV1::encodeMove(const PieceMove& move) {
+    return (move.from.i * 8 + move.from.j) | ((move.to.i * 8 + move.to.j) << 6) | (move.promoteTo << 12);
+}
+
+PieceMove EngineV1::decodeMove(uint16_t code) {
+    if (code == 0) return invalidMove;
+    PieceMove move((code & 63) / 8, (code & 63) % 8, ((code >> 6) & 63) / 8, ((code >> 6) & 63) % 8);
+    move.promoteTo = PieceType(code >> 12);
+    return move;
 }
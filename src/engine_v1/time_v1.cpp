@@ -0,0 +1,87 @@
+#include "engine_v1.hpp"
+
+void TimeManager::setMoveTime(std::chrono::milliseconds time) {
+    useClock = false;
+    moveTime = time;
+}
+
+void TimeManager::setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment) {
+    useClock = true;
+    clockRemaining = remaining;
+    clockIncrement = increment;
+}
+
+void TimeManager::start(int legalMovesCount) {
+    startTime = std::chrono::steady_clock::now();
+
+    if (useClock) {
+        //The time that can be safely used, keeping some for the overhead
+        std::chrono::milliseconds available = std::max(MIN_MOVE_TIME, clockRemaining - MOVE_OVERHEAD);
+        optimumTime = std::chrono::duration_cast<std::chrono::milliseconds>(available / MOVES_TO_GO + clockIncrement * INCREMENT_USAGE);
+        maximumTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::min(optimumTime * MAX_EXTENSION, available * MAX_REMAINING_USAGE));
+        maximumTime = std::max(MIN_MOVE_TIME, maximumTime);
+        optimumTime = std::min(optimumTime, maximumTime);
+        softLimit = optimumTime;
+    }
+    else {
+        optimumTime = moveTime;
+        maximumTime = moveTime;
+        softLimit = std::chrono::duration_cast<std::chrono::milliseconds>(moveTime * SOFT_TIME_RATIO);
+    }
+
+    //If there is only one legal move, the first iteration is enough
+    if (legalMovesCount <= 1) softLimit = std::chrono::milliseconds(0);
+
+    iterations = 0;
+    lastBestMove = invalidMove;
+    lastScore = 0;
+    stableIterations = 0;
+    bestMoveInstability = 0.0;
+}
+
+void TimeManager::iterationFinished(const PieceMove& bestMove, int score) {
+    ++iterations;
+    if (iterations > 1 && bestMove != lastBestMove) {
+        stableIterations = 0;
+        bestMoveInstability += BEST_MOVE_CHANGE_FACTOR;
+    }
+    else ++stableIterations;
+    bestMoveInstability *= 0.75;
+
+    //The soft limit is adapted from the base one, the single legal move case is kept
+    if (softLimit.count() > 0) {
+        double factor = 1.0 + bestMoveInstability;
+        if (iterations >= STABILITY_MIN_ITERATIONS && stableIterations >= STABLE_ITERATIONS) factor *= STABLE_FACTOR;
+
+        //If the score drops, there may be a problem that needs more time to be solved
+        int scoreDrop = lastScore - score;
+        if (iterations > 1 && scoreDrop > SCORE_DROP_MARGIN)
+            factor *= 1.0 + std::min(1.0, double(scoreDrop) / SCORE_DROP_SCALE);
+
+        std::chrono::milliseconds baseLimit = useClock ? optimumTime : std::chrono::duration_cast<std::chrono::milliseconds>(moveTime * SOFT_TIME_RATIO);
+        softLimit = std::min(maximumTime, std::chrono::duration_cast<std::chrono::milliseconds>(baseLimit * factor));
+    }
+
+    lastBestMove = bestMove;
+    lastScore = score;
+}
+
+bool TimeManager::softLimitReached() const {
+    return elapsed() >= softLimit;
+}
+
+bool TimeManager::hardLimitReached() const {
+    return std::chrono::steady_clock::now() - startTime >= maximumTime;
+}
+
+std::chrono::milliseconds TimeManager::elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+}
+
+std::chrono::milliseconds TimeManager::getOptimumTime() const {
+    return optimumTime;
+}
+
+std::chrono::milliseconds TimeManager::getMaximumTime() const {
+    return maximumTime;
+}
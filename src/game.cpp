@@ -18,12 +18,24 @@ void Game::run(int argc, char* argv[]) {
     std::string blackPlayerName = "Player";
     bool displayGUIApp = true;
     std::chrono::milliseconds engineTimeSpan(2000);
+    bool enginePonder = false;
+    int engineMultiPV = 1;
+    std::string engineNetworkFile = ""; //Without a network, the engines use the hand-written evaluation
+    ChessClock gameClock; //Disabled unless a time control is specified
     std::string fenBoard = "";
 
     //Handles the command line arguments
-    processCommandLine(argc, argv, whitePlayerName, blackPlayerName, displayGUIApp, engineTimeSpan, fenBoard);
+    processCommandLine(argc, argv, whitePlayerName, blackPlayerName, displayGUIApp, engineTimeSpan, enginePonder, engineMultiPV, engineNetworkFile, gameClock, fenBoard);
 
-    printOptionsChosen(whitePlayerName, blackPlayerName, displayGUIApp, engineTimeSpan, fenBoard);
+    printOptionsChosen(whitePlayerName, blackPlayerName, displayGUIApp, engineTimeSpan, enginePonder, engineMultiPV, engineNetworkFile, gameClock, fenBoard);
+
+    //Loads the network of the engines, it's shared by both of them
+    std::shared_ptr<NNUE> engineNetwork;
+    if (engineNetworkFile != "") {
+        engineNetwork = std::make_shared<NNUE>();
+        if (!engineNetwork->load(engineNetworkFile))
+            errorAndExit("ERROR: The network " + engineNetworkFile + " could not be loaded.");
+    }
 
     // Inicialization of the app and the board
     std::shared_ptr<Board> myBoard;
@@ -32,8 +44,8 @@ void Game::run(int argc, char* argv[]) {
 
     //Loads both players
     std::unique_ptr<Player> whitePlayer, blackPlayer;
-    loadPlayers(whitePlayer, whitePlayerName, myApp, myBoard, engineTimeSpan);
-    loadPlayers(blackPlayer, blackPlayerName, myApp, myBoard, engineTimeSpan);
+    loadPlayers(whitePlayer, whitePlayerName, myApp, myBoard, engineTimeSpan, enginePonder, engineMultiPV, engineNetwork);
+    loadPlayers(blackPlayer, blackPlayerName, myApp, myBoard, engineTimeSpan, enginePonder, engineMultiPV, engineNetwork);
 
     //Initializes the app, if it fails, the program will exit
     if (!myApp->init())
@@ -50,22 +62,20 @@ void Game::run(int argc, char* argv[]) {
     std::thread eventThread(eventDetector, std::ref(myApp), std::ref(whitePlayer), std::ref(blackPlayer));
 
     //The match starts here
-    PieceMove move;
+    PieceColor flagFallColor = NONE_COLOR;
     while (running) {
+        PieceColor turn = myBoard->getMoveTurn();
+
+        //The clock of the player to move runs since its turn started. After an undo, it starts again for the new player to move
+        if (gameClock.isEnabled() && gameClock.getRunningColor() != turn) gameClock.start(turn);
+
         //Player movement logic
-        if (myBoard->getMoveTurn() == WHITE && whitePlayer->canMove() && !gameInIdle) {
-            move = whitePlayer->getMove();
-            if (!whitePlayer->wasInterrupted()) {
-                myBoard->movePiece(move);
-                myBoard->printLastMove();
-            }
-        }
-        else if (myBoard->getMoveTurn() == BLACK && blackPlayer->canMove() && !gameInIdle) {
-            move = blackPlayer->getMove();
-            if (!blackPlayer->wasInterrupted()) {
-                myBoard->movePiece(move);
-                myBoard->printLastMove();
-            }
+        playTurn(turn == WHITE ? whitePlayer : blackPlayer, myBoard, gameClock);
+
+        //If the player has run out of time, the game is over
+        if (gameClock.flagFell(turn)) {
+            flagFallColor = turn;
+            break;
         }
 
         eventHandler(myBoard);
@@ -78,7 +88,9 @@ void Game::run(int argc, char* argv[]) {
     }
 
     //Check if the game has concluded, then print the result
-    if (myBoard->getBoardResult() != PLAYING) myBoard->printResult();
+    if (flagFallColor != NONE_COLOR) printFlagFall(flagFallColor);
+    else if (myBoard->getBoardResult() != PLAYING) myBoard->printResult();
+    gameClock.printStatistics();
 
     //Waits for the user to close the app
     while(running) eventHandler(myBoard);
@@ -87,6 +99,35 @@ void Game::run(int argc, char* argv[]) {
     if (eventThread.joinable()) eventThread.join();
 }
 
+void Game::playTurn(std::unique_ptr<Player>& player, std::shared_ptr<Board> myBoard, ChessClock& gameClock) {
+    if (!player->canMove() || gameInIdle) return;
+
+    PieceColor turn = myBoard->getMoveTurn();
+    if (gameClock.isEnabled()) player->setClock(gameClock.getRemaining(turn), gameClock.getIncrement());
+
+    PieceMove move = player->getMove();
+    if (player->wasInterrupted()) return;
+
+    //The move is only made if the player has not run out of time while thinking
+    if (gameClock.isEnabled()) gameClock.stop();
+    if (gameClock.flagFell(turn)) return;
+
+    myBoard->movePiece(move);
+    myBoard->printLastMove();
+    gameClock.printLastMove();
+}
+
+void Game::printFlagFall(PieceColor col) {
+    if (col == WHITE)
+        std::cout << "======================================\n" <<
+                     "||        WHITE LOST ON TIME        ||\n" <<
+                     "======================================\n";
+    else
+        std::cout << "======================================\n" <<
+                     "||        BLACK LOST ON TIME        ||\n" <<
+                     "======================================\n";
+}
+
 void Game::eventHandler(std::shared_ptr<Board> myBoard) {
     if (lastEvent == MyApp::QUIT) {
         running = false;
@@ -132,7 +173,11 @@ void Game::printUsage(const char* programName) {
     std::cout << "    --white, -w <Player | <engine_name>>: specify who will play with the white pieces." << std::endl;
     std::cout << "    --black, -b <Player | <engine_name>>: specify who will play with the black pieces." << std::endl;
     std::cout << "    --console-only, -c: the GUI will not be displayed." << std::endl;
-    std::cout << "    --timespan <time>, -t <time>: the time span in seconds for the engine to play a turn, can use decimals." << std::endl;
+    std::cout << "    --ponder, -p: the engines keep searching during the opponent's turn, assuming the reply they expect." << std::endl;
+    std::cout << "    --multipv <lines>, -m <lines>: the engines search the best <lines> moves, reporting a line for each one." << std::endl;
+    std::cout << "    --nnue <file>, -n <file>: the engines evaluate the boards with the neural network loaded from <file> instead of the hand-written evaluation." << std::endl;
+    std::cout << "    --timespan <time>, -t <time>: the maximum time span in seconds for the engine to play a turn, can use decimals." << std::endl;
+    std::cout << "    --tc <time>[+<increment>], -T <time>[+<increment>]: play with a clock, each player has <time> seconds for the whole game and gets <increment> seconds after each move, can use decimals. The engines budget their time from their clock instead of using the time span." << std::endl;
     std::cout << "    --load-fen \"<fen>\", -f \"<fen>\": load a FEN board. IMPORTANT: The FEN string must be enclosed in quotes." << std::endl;
     std::cout << std::endl;
     std::cout << "The default options are:" << std::endl;
@@ -152,17 +197,23 @@ void Game::printWelcome(unsigned int seed) {
     std::cout << "----------------------------------------------------" << std::endl << std::endl;;
 }
 
-void Game::printOptionsChosen(const std::string& whitePlayer,const std::string& blackPlayer, bool displayGUIApp, std::chrono::milliseconds engineTimeSpan, const std::string& FEN) {
+void Game::printOptionsChosen(const std::string& whitePlayer,const std::string& blackPlayer, bool displayGUIApp, std::chrono::milliseconds engineTimeSpan, bool enginePonder, int engineMultiPV, const std::string& engineNetworkFile, const ChessClock& gameClock, const std::string& FEN) {
     std::cout << "Options chosen:" << std::endl;
     std::cout << "    - White player: " << whitePlayer << std::endl;
     std::cout << "    - Black player: " << blackPlayer << std::endl;
     std::cout << "    - Display method: " << (displayGUIApp ? "GUI" : "Console") << std::endl;
-    std::cout << "    - Engine time span: " << engineTimeSpan.count() / 1000.0 << " s" << std::endl;
+    if (gameClock.isEnabled()) 
+        std::cout << "    - Time control: " << gameClock.getRemaining(WHITE).count() / 1000.0 << " s + " << gameClock.getIncrement().count() / 1000.0 << " s" << std::endl;
+    else
+        std::cout << "    - Engine time span: " << engineTimeSpan.count() / 1000.0 << " s" << std::endl;
+    std::cout << "    - Engine pondering: " << (enginePonder ? "Yes" : "No") << std::endl;
+    std::cout << "    - Engine lines (multi-PV): " << engineMultiPV << std::endl;
+    std::cout << "    - Engine evaluation: " << (engineNetworkFile == "" ? "hand-written" : "NNUE, " + engineNetworkFile) << std::endl;
     std::cout << "    - FEN: " << (FEN == "" ? "default" : FEN) << std::endl;
     std::cout << "----------------------------------------------------" << std::endl << std::endl;;
 }
 
-void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer, std::string& blackPlayer, bool& displayGUIApp, std::chrono::milliseconds& engineTimeSpan, std::string& FEN) {
+void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer, std::string& blackPlayer, bool& displayGUIApp, std::chrono::milliseconds& engineTimeSpan, bool& enginePonder, int& engineMultiPV, std::string& engineNetworkFile, ChessClock& gameClock, std::string& FEN) {
     if (argc == 1)
         return;
 
@@ -172,7 +223,11 @@ void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer,
         {"black",        no_argument,       0, 'b'},
         {"white",        no_argument,       0, 'w'},
         {"console-only", no_argument,       0, 'c'},
+        {"ponder",       no_argument,       0, 'p'},
+        {"multipv",      required_argument, 0, 'm'},
+        {"nnue",         required_argument, 0, 'n'},
         {"timespan",     required_argument, 0, 't'},
+        {"tc",           required_argument, 0, 'T'},
         {"load-fen",     required_argument, 0, 'f'},
         {0, 0, 0, 0}
     };
@@ -180,7 +235,7 @@ void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer,
     //Handles the options
     int opt;
     int optionIndex = 0;
-    while ((opt = getopt_long(argc, argv, "hb:w:ct:f:", longOptions, &optionIndex)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hb:w:cpm:n:t:T:f:", longOptions, &optionIndex)) != -1) {
         switch (opt) {
             case 'h': //Help
                 printUsage(argv[0]);
@@ -196,10 +251,28 @@ void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer,
             case 'c': //Console only
                 displayGUIApp = false;
                 break;
+            case 'p': //Engine pondering
+                enginePonder = true;
+                break;
+            case 'm': //Engine multi-PV
+                try {
+                    engineMultiPV = std::stoi(optarg);
+                }
+                catch (const std::exception&) {
+                    errorAndExit("ERROR: Invalid number of lines " + std::string(optarg) + ".");
+                }
+                if (engineMultiPV < 1) errorAndExit("ERROR: The number of lines must be at least 1.");
+                break;
+            case 'n': //Engine network
+                engineNetworkFile = optarg;
+                break;
             case 't': //Engine time span
                 //stof
                 engineTimeSpan = std::chrono::milliseconds(int(std::stof(optarg) * 1000));
                 break;
+            case 'T': //Time control
+                parseTimeControl(optarg, gameClock);
+                break;
             case 'f': //Load FEN
                 FEN = optarg;
                 break;
@@ -211,6 +284,24 @@ void Game::processCommandLine(int argc, char* argv[], std::string& whitePlayer,
     return;
 }
 
+void Game::parseTimeControl(const std::string& timeControl, ChessClock& gameClock) {
+    size_t plusPos = timeControl.find('+');
+    std::string timeStr = timeControl.substr(0, plusPos);
+    std::string incrementStr = (plusPos == std::string::npos) ? "0" : timeControl.substr(plusPos + 1);
+
+    float time = 0, increment = 0;
+    try {
+        time = std::stof(timeStr);
+        increment = std::stof(incrementStr);
+    }
+    catch (const std::exception&) {
+        errorAndExit("ERROR: Invalid time control " + timeControl + ", the format is <time>[+<increment>].");
+    }
+    if (time <= 0 || increment < 0) errorAndExit("ERROR: Invalid time control " + timeControl + ", the time must be positive.");
+
+    gameClock.setTimeControl(std::chrono::milliseconds(int(time * 1000)), std::chrono::milliseconds(int(increment * 1000)));
+}
+
 void Game::initializeBoardApp(std::shared_ptr<Board>& myBoard, std::shared_ptr<MyApp>& myApp, bool displayGUIApp, const std::string& FEN) {
     //Initializes the board
     myBoard = std::make_shared<Board>();
@@ -227,9 +318,9 @@ void Game::initializeBoardApp(std::shared_ptr<Board>& myBoard, std::shared_ptr<M
     else myBoard->loadFEN(FEN);
 }
 
-void Game::loadPlayers(std::unique_ptr<Player>& player, const std::string& playerName, std::shared_ptr<MyApp> myApp, std::shared_ptr<Board> myBoard, std::chrono::milliseconds engineTimeSpan) {
+void Game::loadPlayers(std::unique_ptr<Player>& player, const std::string& playerName, std::shared_ptr<MyApp> myApp, std::shared_ptr<Board> myBoard, std::chrono::milliseconds engineTimeSpan, bool enginePonder, int engineMultiPV, std::shared_ptr<const NNUE> engineNetwork) {
     if (playerName == "Player") player = std::make_unique<HumanPlayer>(myApp);
     else if (playerName == "RandomEngine") player = std::make_unique<RandomEngine>(myBoard);
-    else if (playerName == "EngineV1") player = std::make_unique<EngineV1>(myBoard, engineTimeSpan);
+    else if (playerName == "EngineV1") player = std::make_unique<EngineV1>(myBoard, engineTimeSpan, enginePonder, engineMultiPV, engineNetwork);
     else errorAndExit("ERROR: " + playerName + " is not a valid player.");
 }
\ No newline at end of file
@@ -293,7 +293,7 @@ void Board::targetedByBishop(uint64_t bit) {
     std::pair<int, int> from = bitToij(bit);
     uint64_t *myPieces = (bit & whitePieces) ? &whitePieces : &blackPieces;
     uint64_t *opponentPieces = (bit & whitePieces) ? &blackPieces : &whitePieces;
-    uint64_t *opponentTargetedeSquares = (moveTurn == WHITE) ? &blackTargetedSquares : &whiteTargetedSquares;
+    uint64_t *opponentTargetedeSquares = (bit & whitePieces) ? &blackTargetedSquares : &whiteTargetedSquares;
     uint64_t *opponentKing = (bit & whitePieces) ? &blackKing : &whiteKing;
     uint64_t *opponentPinned = (bit & whitePieces) ? &blackPinnedSquares : &whitePinnedSquares;
     uint64_t pinned;
@@ -403,4 +403,24 @@ void Board::targetedByKing(uint64_t bit) {
             *opponentTargetedeSquares |= aux;
         }
     }
-}
\ No newline at end of file
+}
+
+uint64_t Board::getAttackers(int i, int j, uint64_t occupied) const {
+    int square = 8 * i + 7 - j;
+    uint64_t bit = uint64_t(1) << square;
+    uint64_t attackers = 0;
+
+    //A white pawn attacks the square from where a black pawn on it would attack, and vice versa
+    attackers |= Attacks::pawns(bit, BLACK) & whitePawn;
+    attackers |= Attacks::pawns(bit, WHITE) & blackPawn;
+
+    //Knights and kings
+    attackers |= Attacks::knight(square) & (whiteKnight | blackKnight);
+    attackers |= Attacks::king(square) & (whiteKing | blackKing);
+
+    //Sliding pieces, the first piece found in each direction
+    attackers |= Attacks::rook(square, occupied) & (whiteRook | blackRook | whiteQueen | blackQueen);
+    attackers |= Attacks::bishop(square, occupied) & (whiteBishop | blackBishop | whiteQueen | blackQueen);
+
+    return attackers & occupied;
+}
@@ -6,6 +6,8 @@ Player::Player() {
     interrupted = false;
 }
 
+void Player::setClock(std::chrono::milliseconds, std::chrono::milliseconds) { }
+
 void Player::interrupt() {
     interrupted = true;
 }
@@ -0,0 +1,109 @@
+#include "testing.hpp"
+#include "board.hpp"
+
+//  Positions with castles, en passant captures, promotions and checks
+static const std::vector<std::string> TEST_FENS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+};
+
+//  Returns a random legal move of the board
+static PieceMove randomMove(Board& board, std::mt19937& random) {
+    const std::set<PieceMove>& moves = board.getCurrentLegalMoves();
+    auto it = moves.begin();
+    std::advance(it, random() % moves.size());
+    return *it;
+}
+
+//  Checks the state kept incrementally by the board against the one of a board loaded from its FEN, which is calculated from scratch
+static void checkAgainstScratch(Board& board) {
+    Board scratch;
+    scratch.loadFEN(board.getFEN());
+    CHECK(board.getZobristHash() == scratch.getZobristHash());
+    CHECK(board.getPawnHash() == scratch.getPawnHash());
+    CHECK(board.getMaterialKey() == scratch.getMaterialKey());
+    CHECK(board.getPieceSquareScore() == scratch.getPieceSquareScore());
+    CHECK(board.getPhase() == scratch.getPhase());
+    CHECK(board.isInCheck() == scratch.isInCheck());
+    CHECK(board.getCurrentLegalMoves() == scratch.getCurrentLegalMoves());
+}
+
+//  Plays random games, checking the incremental state after each move and null move, that undoing them restores the board, and that the check of each move is known before making it
+static void testIncrementalState() {
+    std::mt19937 random(12345);
+    for (const std::string& fen : TEST_FENS) {
+        for (int game = 0; game < 10; ++game) {
+            Board board;
+            board.loadFEN(fen);
+            for (int ply = 0; ply < 100 && board.getBoardResult() == PLAYING; ++ply) {
+                checkAgainstScratch(board);
+                std::string fenBefore = board.getFEN();
+                uint64_t hashBefore = board.getZobristHash();
+
+                //The null move is undone with or without its legal moves calculated, which are restored in different ways
+                if (!board.isInCheck()) {
+                    board.makeNullMove();
+                    if (ply % 2 == 0) checkAgainstScratch(board);
+                    board.undoNullMove();
+                    CHECK(board.getFEN() == fenBefore);
+                    CHECK(board.getZobristHash() == hashBefore);
+                }
+
+                PieceMove move = randomMove(board, random);
+                bool givesCheck = board.givesCheck(move);
+                board.movePiece(move);
+                CHECK(givesCheck == board.isInCheck());
+                checkAgainstScratch(board);
+                board.undoMove();
+                CHECK(board.getFEN() == fenBefore);
+                CHECK(board.getZobristHash() == hashBefore);
+
+                board.movePiece(move);
+            }
+        }
+    }
+}
+
+//  The FEN of a loaded board is the same one, apart from the halfmove clock
+static void testFENRoundTrip() {
+    for (const std::string& fen : TEST_FENS) {
+        Board board;
+        board.loadFEN(fen);
+        CHECK(board.getFEN() == fen);
+    }
+    Board board;
+    board.loadFEN("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 12");
+    CHECK(board.getFEN() == "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 0 12");
+}
+
+//  The check and the result of a loaded position are calculated for the side to move, also when the board is reused for another position
+static void testLoadedPositions() {
+    Board board;
+    board.loadFEN("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    CHECK(board.isInCheck());
+    CHECK(board.getBoardResult() == CHECKMATE);
+
+    board.loadFEN("rnbqk1nr/pppp1ppp/8/4p3/1b6/3P4/PPP1PPPP/RNBQKBNR w KQkq - 1 3");
+    CHECK(board.isInCheck());
+    CHECK(board.getBoardResult() == PLAYING);
+    CHECK(board.getCurrentLegalMoves().size() == 5);
+
+    board.loadFEN("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    CHECK(!board.isInCheck());
+    CHECK(board.getBoardResult() == STALE_MATE);
+
+    board.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    CHECK(!board.isInCheck());
+    CHECK(board.getBoardResult() == PLAYING);
+    CHECK(board.getCurrentLegalMoves().size() == 20);
+}
+
+int main() {
+    testFENRoundTrip();
+    testLoadedPositions();
+    testIncrementalState();
+    return testResult();
+}
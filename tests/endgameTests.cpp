@@ -0,0 +1,53 @@
+#include "testing.hpp"
+#include "board.hpp"
+#include "engine_v1.hpp"
+
+//  The static evaluation of a position, in centipawns from the perspective of the player to move
+static int evaluate(const std::string& fen) {
+    std::shared_ptr<Board> board = std::make_shared<Board>();
+    board->loadFEN(fen);
+    std::unique_ptr<EngineV1> engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(10), false);
+    engine->setVerbose(false);
+    return engine->staticEvaluation();
+}
+
+//  The evaluation of a won endgame is above this one, far from the ones of the middlegame
+static constexpr int KNOWN_WIN = 5000;
+
+//  The pawn is a win when the weak king can't catch it, by the rule of the square, and a draw when it's a rook pawn with the weak king in its corner
+static void testKPK() {
+    CHECK(evaluate("8/8/8/8/8/k7/6P1/6K1 w - - 0 1") > KNOWN_WIN);
+    CHECK(evaluate("8/8/8/8/8/8/6P1/k5K1 b - - 0 1") < -KNOWN_WIN);
+    CHECK(evaluate("6k1/6p1/K7/8/8/8/8/8 b - - 0 1") > KNOWN_WIN);
+
+    //The king catches the pawn when it's its turn, so it isn't a known win
+    int caught = evaluate("8/8/8/8/8/1k6/6P1/6K1 b - - 0 1");
+    CHECK(caught > -KNOWN_WIN && caught < 0);
+
+    CHECK(evaluate("k7/8/8/8/8/8/P7/K7 w - - 0 1") == 0);
+    CHECK(evaluate("8/8/8/8/8/6k1/7p/7K b - - 0 1") == 0);
+}
+
+//  The mate is forced in a corner of the color of the bishop, so the weak king is pushed to those corners
+static void testKBNK() {
+    //Dark squared bishop, whose corners are a1 and h8
+    int darkCorner = evaluate("8/8/8/8/4N3/2K5/8/k1B5 w - - 0 1");
+    int lightCorner = evaluate("8/8/8/8/3N4/5K2/8/2B4k w - - 0 1");
+    CHECK(darkCorner > KNOWN_WIN && lightCorner > KNOWN_WIN);
+    CHECK(darkCorner > lightCorner);
+
+    //Light squared bishop, whose corners are h1 and a8
+    lightCorner = evaluate("8/8/8/8/3N4/5K2/8/5B1k w - - 0 1");
+    darkCorner = evaluate("8/8/8/8/4N3/2K5/8/k4B2 w - - 0 1");
+    CHECK(darkCorner > KNOWN_WIN && lightCorner > KNOWN_WIN);
+    CHECK(lightCorner > darkCorner);
+
+    //The same for black, from the perspective of white
+    CHECK(evaluate("K1b5/8/2k5/4n3/8/8/8/8 w - - 0 1") < evaluate("2b4K/8/5k2/3n4/8/8/8/8 w - - 0 1"));
+}
+
+int main() {
+    testKPK();
+    testKBNK();
+    return testResult();
+}
@@ -0,0 +1,132 @@
+#include "testing.hpp"
+#include "board.hpp"
+#include "nnue.hpp"
+
+//  The implementation of the inner loops of the network chosen by the compiler flags, this test is built once for each one
+#if defined(__AVX2__)
+static const std::string IMPLEMENTATION = "AVX2";
+#elif defined(__SSE4_1__)
+static const std::string IMPLEMENTATION = "SSE4.1";
+#else
+static const std::string IMPLEMENTATION = "plain loops";
+#endif
+
+//  A network with random weights, small enough that the accumulators can't overflow, kept to compute the evaluation without the NNUE class
+struct TestNetwork {
+    std::vector<int16_t> featureWeights; //[INPUT_SIZE][HIDDEN_SIZE]
+    std::vector<int16_t> featureBiases;
+    std::vector<int16_t> outputWeights; //The ones of the player to move first
+    int16_t outputBias;
+};
+
+static TestNetwork randomNetwork(std::mt19937& random) {
+    std::uniform_int_distribution<int> featureWeight(-64, 64), bias(-32, 96), outputWeight(-127, 127);
+    TestNetwork network;
+    for (int i = 0; i < NNUE::INPUT_SIZE * NNUE::HIDDEN_SIZE; ++i) network.featureWeights.push_back(featureWeight(random));
+    for (int i = 0; i < NNUE::HIDDEN_SIZE; ++i) network.featureBiases.push_back(bias(random));
+    for (int i = 0; i < 2 * NNUE::HIDDEN_SIZE; ++i) network.outputWeights.push_back(outputWeight(random));
+    network.outputBias = outputWeight(random) * 100;
+    return network;
+}
+
+//  Writes the network in the file format of the NNUE class
+static bool writeNetwork(const TestNetwork& network, const std::string& fileName) {
+    std::ofstream file(fileName, std::ios::binary);
+    auto write = [&file](int16_t value) {
+        file.put(char(uint16_t(value) & 0xff));
+        file.put(char(uint16_t(value) >> 8));
+    };
+    for (int16_t value : network.featureWeights) write(value);
+    for (int16_t value : network.featureBiases) write(value);
+    for (int16_t value : network.outputWeights) write(value);
+    write(network.outputBias);
+    return bool(file);
+}
+
+//  The evaluation of the board from the definition of the network in nnue.hpp, with plain integer arithmetic
+static int referenceEvaluation(const TestNetwork& network, const Board& board) {
+    //The input order of the pieces is pawn, knight, bishop, rook, queen, king, indexed by PieceType
+    const int PIECE_INDEX[12] = {0, 2, 1, 3, 4, 5, 0, 2, 1, 3, 4, 5};
+
+    int accumulators[2][NNUE::HIDDEN_SIZE];
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+        for (int h = 0; h < NNUE::HIDDEN_SIZE; ++h) accumulators[perspective][h] = network.featureBiases[h];
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                PieceType pt = board.getPieceType(i, j);
+                if (pt == NONE) continue;
+                //a1 is 0 and h8 is 63 from white's side, the ranks are flipped for black
+                int square = (perspective == WHITE) ? (7 - i) * 8 + j : i * 8 + j;
+                int input = (pieceColor(pt) == perspective ? 0 : 384) + 64 * PIECE_INDEX[pt] + square;
+                for (int h = 0; h < NNUE::HIDDEN_SIZE; ++h) accumulators[perspective][h] += network.featureWeights[input * NNUE::HIDDEN_SIZE + h];
+            }
+        }
+    }
+
+    int moveTurn = board.getMoveTurn();
+    int output = network.outputBias;
+    for (int h = 0; h < NNUE::HIDDEN_SIZE; ++h) {
+        output += std::clamp(accumulators[moveTurn][h], 0, NNUE::QA) * network.outputWeights[h];
+        output += std::clamp(accumulators[1 - moveTurn][h], 0, NNUE::QA) * network.outputWeights[NNUE::HIDDEN_SIZE + h];
+    }
+    return output * NNUE::SCALE / (NNUE::QA * NNUE::QB);
+}
+
+static bool sameAccumulator(const NNUE::Accumulator& a, const NNUE::Accumulator& b) {
+    return std::equal(&a.values[0][0], &a.values[0][0] + 2 * NNUE::HIDDEN_SIZE, &b.values[0][0]);
+}
+
+//  Plays random games, checking the evaluation against the reference, and the accumulators updated with each move against the ones computed from scratch
+static void testNetwork(const NNUE& nnue, const TestNetwork& network, std::mt19937& random) {
+    for (int game = 0; game < 20; ++game) {
+        Board board;
+        board.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        NNUE::Accumulator accumulator, refreshed;
+        nnue.refresh(board, accumulator);
+        for (int ply = 0; ply < 120 && board.getBoardResult() == PLAYING; ++ply) {
+            nnue.refresh(board, refreshed);
+            CHECK(sameAccumulator(accumulator, refreshed));
+            CHECK(nnue.evaluate(accumulator, board.getMoveTurn()) == referenceEvaluation(network, board));
+
+            const std::set<PieceMove>& moves = board.getCurrentLegalMoves();
+            auto it = moves.begin();
+            std::advance(it, random() % moves.size());
+            PieceMove move = *it;
+            board.movePiece(move);
+
+            NNUE::Accumulator next;
+            nnue.update(accumulator, next, board.getPieceChanges(), board.getPieceChangesCount());
+            accumulator = next;
+        }
+    }
+}
+
+int main() {
+    //The instructions of the implementation may not be available on this CPU
+#if defined(__AVX2__)
+    if (!__builtin_cpu_supports("avx2")) return TEST_SKIPPED;
+#elif defined(__SSE4_1__)
+    if (!__builtin_cpu_supports("sse4.1")) return TEST_SKIPPED;
+#endif
+    std::cout << "[INFO] Testing the network with " << IMPLEMENTATION << std::endl;
+
+    std::mt19937 random(2024);
+    TestNetwork network = randomNetwork(random);
+    std::string fileName = (std::filesystem::temp_directory_path() / ("nnueTests-" + std::to_string(getpid()) + ".nnue")).string();
+    CHECK(writeNetwork(network, fileName));
+
+    NNUE nnue;
+    bool loaded = nnue.load(fileName);
+    std::filesystem::remove(fileName);
+    CHECK(loaded);
+    if (loaded) testNetwork(nnue, network, random);
+
+    //A file of another size isn't loaded
+    TestNetwork smaller = network;
+    smaller.outputWeights.pop_back();
+    CHECK(writeNetwork(smaller, fileName));
+    CHECK(!nnue.load(fileName));
+    std::filesystem::remove(fileName);
+
+    return testResult();
+}
@@ -0,0 +1,100 @@
+#include "testing.hpp"
+#include "board.hpp"
+#include "engine_v1.hpp"
+
+//  Middlegame positions with captures, checks and castles, and an endgame with passed pawns
+static const std::vector<std::string> TEST_FENS = {
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+//  Checks that every move of the principal variations found by the search is legal in the board reached by the previous ones
+static void checkPVLines(const EngineV1& engine, const Board& board) {
+    for (const EngineV1::PVLine& line : engine.getPVLines()) {
+        CHECK(!line.pv.empty() && line.pv.front() == line.move);
+        Board copy = board;
+        for (PieceMove move : line.pv) {
+            bool legal = copy.getCurrentLegalMoves().count(move) > 0;
+            CHECK(legal);
+            if (!legal) break;
+            copy.movePiece(move);
+        }
+    }
+}
+
+//  Plays some moves of each position with short searches of different lengths, which are the ones most likely to stop in the middle of an iteration
+static void testPVLegality() {
+    for (int timeSpan : {3, 5, 8, 13, 20}) {
+        for (const std::string& fen : TEST_FENS) {
+            std::shared_ptr<Board> board = std::make_shared<Board>();
+            board->loadFEN(fen);
+            std::unique_ptr<EngineV1> engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(timeSpan), false);
+            engine->setVerbose(false);
+            for (int ply = 0; ply < 6 && board->getBoardResult() == PLAYING; ++ply) {
+                PieceMove move = engine->getMove();
+                CHECK(engine->getPVLines().size() == 1);
+                CHECK(board->getCurrentLegalMoves().count(move) > 0);
+                checkPVLines(*engine, *board);
+                board->movePiece(move);
+            }
+        }
+    }
+}
+
+//  With Multi-PV, the lines have different first moves and are sorted from best to worst, the first one being the move played. There are as many as asked unless there are fewer legal moves, or the search was too short to finish its first iteration
+static void testMultiPV() {
+    for (int timeSpan : {10, 30, 60}) {
+        for (const std::string& fen : TEST_FENS) {
+            std::shared_ptr<Board> board = std::make_shared<Board>();
+            board->loadFEN(fen);
+            std::unique_ptr<EngineV1> engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(timeSpan), false, 3);
+            engine->setVerbose(false);
+            for (int ply = 0; ply < 4 && board->getBoardResult() == PLAYING; ++ply) {
+                PieceMove move = engine->getMove();
+                const std::vector<EngineV1::PVLine>& lines = engine->getPVLines();
+                CHECK(lines.size() <= std::min<size_t>(3, board->getCurrentLegalMoves().size()));
+                CHECK(!lines.empty() && lines.front().move == move);
+                for (size_t i = 1; i < lines.size(); ++i) {
+                    CHECK(lines[i].eval <= lines[i - 1].eval);
+                    for (size_t k = 0; k < i; ++k) CHECK(!(lines[i].move == lines[k].move));
+                }
+                checkPVLines(*engine, *board);
+                board->movePiece(move);
+            }
+        }
+    }
+
+    std::shared_ptr<Board> board = std::make_shared<Board>();
+    board->loadFEN(TEST_FENS[0]);
+    std::unique_ptr<EngineV1> engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(200), false, 3);
+    engine->setVerbose(false);
+    engine->getMove();
+    CHECK(engine->getPVLines().size() == 3);
+
+    board->loadFEN("7k/8/8/8/8/8/8/K6R b - - 0 1");
+    engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(20), false, 3);
+    engine->setVerbose(false);
+    engine->getMove();
+    CHECK(engine->getPVLines().size() == 2);
+}
+
+//  The mate in one is always found
+static void testMateInOne() {
+    std::shared_ptr<Board> board = std::make_shared<Board>();
+    board->loadFEN("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    std::unique_ptr<EngineV1> engine = std::make_unique<EngineV1>(board, std::chrono::milliseconds(20), false);
+    engine->setVerbose(false);
+    PieceMove move = engine->getMove();
+    board->movePiece(move);
+    CHECK(board->getBoardResult() == CHECKMATE);
+}
+
+int main() {
+    testPVLegality();
+    testMultiPV();
+    testMateInOne();
+    return testResult();
+}
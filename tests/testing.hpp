@@ -0,0 +1,27 @@
+#ifndef TESTING_HH
+#define TESTING_HH
+
+#include "utils.hpp"
+
+//  Checks of the test executables, run by ctest. A failed check prints the condition and where it is, and the test goes on with the next one. The test fails if any check has failed.
+inline int failedChecks = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ++failedChecks; \
+            std::cerr << "[FAIL] " << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+        } \
+    } while (0)
+
+//  Returns the exit code of the test, printing the number of failed checks
+inline int testResult() {
+    if (failedChecks == 0) std::cout << "[INFO] All the checks passed" << std::endl;
+    else std::cout << "[INFO] Failed checks: " << failedChecks << std::endl;
+    return failedChecks == 0 ? 0 : 1;
+}
+
+//  A test whose instructions can't be run on this CPU exits with this code, which ctest reports as skipped
+static constexpr int TEST_SKIPPED = 77;
+
+#endif
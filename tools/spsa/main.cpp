@@ -0,0 +1,6 @@
+#include "spsa.hpp"
+
+int main(int argc, char* argv[]) {
+    Spsa::run(argc, argv);
+    return 0;
+}
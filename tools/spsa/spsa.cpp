@@ -0,0 +1,246 @@
+#include "spsa.hpp"
+
+const std::vector<Spsa::Parameter> Spsa::PARAMETERS = {
+    {"aspirationWindow", 10, 150, 5, 0.002,
+        [](const SearchParameters& p) { return double(p.aspirationWindow); }, [](SearchParameters& p, double v) { p.aspirationWindow = std::lround(v); }},
+    {"nullMoveReduction", 1, 4, 0.5, 0.002,
+        [](const SearchParameters& p) { return double(p.nullMoveReduction); }, [](SearchParameters& p, double v) { p.nullMoveReduction = std::lround(v); }},
+    {"nullMoveDepthDivisor", 3, 12, 1, 0.002,
+        [](const SearchParameters& p) { return double(p.nullMoveDepthDivisor); }, [](SearchParameters& p, double v) { p.nullMoveDepthDivisor = std::lround(v); }},
+    {"rfpMargin", 50, 250, 10, 0.002,
+        [](const SearchParameters& p) { return double(p.rfpMargin); }, [](SearchParameters& p, double v) { p.rfpMargin = std::lround(v); }},
+    {"razoringMargin1", 100, 900, 30, 0.002,
+        [](const SearchParameters& p) { return double(p.razoringMargin[1]); }, [](SearchParameters& p, double v) { p.razoringMargin[1] = std::lround(v); }},
+    {"razoringMargin2", 100, 900, 30, 0.002,
+        [](const SearchParameters& p) { return double(p.razoringMargin[2]); }, [](SearchParameters& p, double v) { p.razoringMargin[2] = std::lround(v); }},
+    {"razoringMargin3", 100, 900, 30, 0.002,
+        [](const SearchParameters& p) { return double(p.razoringMargin[3]); }, [](SearchParameters& p, double v) { p.razoringMargin[3] = std::lround(v); }},
+    {"futilityMargin1", 50, 800, 25, 0.002,
+        [](const SearchParameters& p) { return double(p.futilityMargin[1]); }, [](SearchParameters& p, double v) { p.futilityMargin[1] = std::lround(v); }},
+    {"futilityMargin2", 50, 800, 25, 0.002,
+        [](const SearchParameters& p) { return double(p.futilityMargin[2]); }, [](SearchParameters& p, double v) { p.futilityMargin[2] = std::lround(v); }},
+    {"futilityMargin3", 50, 800, 25, 0.002,
+        [](const SearchParameters& p) { return double(p.futilityMargin[3]); }, [](SearchParameters& p, double v) { p.futilityMargin[3] = std::lround(v); }},
+    {"lmrBase", 0, 2, 0.1, 0.002,
+        [](const SearchParameters& p) { return p.lmrBase; }, [](SearchParameters& p, double v) { p.lmrBase = v; }},
+    {"lmrDivisor", 1, 4, 0.15, 0.002,
+        [](const SearchParameters& p) { return p.lmrDivisor; }, [](SearchParameters& p, double v) { p.lmrDivisor = v; }},
+    {"lmrHistoryDivisor", 2048, 32768, 800, 0.002,
+        [](const SearchParameters& p) { return double(p.lmrHistoryDivisor); }, [](SearchParameters& p, double v) { p.lmrHistoryDivisor = std::lround(v); }},
+    {"deltaMargin", 50, 500, 20, 0.002,
+        [](const SearchParameters& p) { return double(p.deltaMargin); }, [](SearchParameters& p, double v) { p.deltaMargin = std::lround(v); }},
+};
+
+void Spsa::run(int argc, char* argv[]) {
+    int iterations = 1000;
+    std::chrono::milliseconds moveTime(20);
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string checkpointFile = "spsa.checkpoint";
+
+    //Options for the command line
+    struct option longOptions[] = {
+        {"help",       no_argument,       0, 'h'},
+        {"iterations", required_argument, 0, 'n'},
+        {"movetime",   required_argument, 0, 'm'},
+        {"threads",    required_argument, 0, 't'},
+        {"checkpoint", required_argument, 0, 'c'},
+        {0, 0, 0, 0}
+    };
+    int opt;
+    int optionIndex = 0;
+    while ((opt = getopt_long(argc, argv, "hn:m:t:c:", longOptions, &optionIndex)) != -1) {
+        try {
+            switch (opt) {
+                case 'h': //Help
+                    printUsage(argv[0]);
+                    break;
+                case 'n': //Iterations
+                    iterations = std::stoi(optarg);
+                    if (iterations < 1) errorAndExit("ERROR: Invalid number of iterations " + std::string(optarg) + ".");
+                    break;
+                case 'm': //Time per move
+                    moveTime = std::chrono::milliseconds(std::stoi(optarg));
+                    if (moveTime.count() < 1) errorAndExit("ERROR: Invalid time per move " + std::string(optarg) + ".");
+                    break;
+                case 't': //Threads
+                    threads = std::stoi(optarg);
+                    if (threads < 1) errorAndExit("ERROR: Invalid number of threads " + std::string(optarg) + ".");
+                    break;
+                case 'c': //Checkpoint file
+                    checkpointFile = optarg;
+                    break;
+                default:
+                    printUsage(argv[0]);
+                    break;
+            }
+        }
+        catch (const std::exception&) {
+            errorAndExit("ERROR: Invalid value " + std::string(optarg) + ".");
+        }
+    }
+
+    //The zobrist table of the boards is initialized once, before the threads use it
+    Board().setDefaulValues();
+
+    Spsa spsa(iterations, moveTime, threads, checkpointFile);
+    if (spsa.loadCheckpoint()) std::cout << "[INFO] Resumed from " << checkpointFile << " after " << spsa.finishedIterations << " iterations" << std::endl;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(&Spsa::worker, &spsa);
+    for (std::thread& worker : workers) worker.join();
+
+    if (!spsa.saveCheckpoint()) errorAndExit("ERROR: The checkpoint " + checkpointFile + " could not be written.");
+    spsa.printProgress();
+}
+
+void Spsa::printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]" << std::endl;
+    std::cout << "Tune the search parameters of the engine with SPSA, playing games between engines with perturbed parameters." << std::endl << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "    --help, -h: Displays this message." << std::endl;
+    std::cout << "    --iterations <iterations>, -n <iterations>: the iterations of the tuning, each one is a pair of games." << std::endl;
+    std::cout << "    --movetime <ms>, -m <ms>: the time span of the engines for each move, in milliseconds." << std::endl;
+    std::cout << "    --threads <threads>, -t <threads>: the iterations played at the same time." << std::endl;
+    std::cout << "    --checkpoint <file>, -c <file>: the file where the progress is saved, the tuning is resumed from it if it exists." << std::endl;
+    std::cout << std::endl;
+    std::cout << "The default options are:" << std::endl;
+    std::cout << "    --iterations 1000 --movetime 20 --threads <all the cores> --checkpoint spsa.checkpoint" << std::endl;
+
+    exit(0);
+}
+
+Spsa::Spsa(int iterations, std::chrono::milliseconds moveTime, int threads, const std::string& checkpointFile)
+    : iterations(iterations), nextIteration(1), finishedIterations(0), pairsScore(0), moveTime(moveTime), threads(threads), checkpointFile(checkpointFile), random(std::random_device()()) {
+    //The tuning starts from the values the engine plays with
+    SearchParameters defaults;
+    for (const Parameter& parameter : PARAMETERS) values.push_back(parameter.get(defaults));
+}
+
+void Spsa::worker() {
+    while (true) {
+        int iteration;
+        uint64_t openingSeed;
+        std::vector<double> delta(PARAMETERS.size()), plusValues(PARAMETERS.size()), minusValues(PARAMETERS.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextIteration > iterations) return;
+            iteration = nextIteration++;
+
+            //Each parameter is perturbed up or down, the perturbation decays with the iterations
+            for (int p = 0; p < PARAMETERS.size(); ++p) {
+                const Parameter& parameter = PARAMETERS[p];
+                double perturbation = parameter.endPerturbation * std::pow(iterations, GAMMA) / std::pow(iteration, GAMMA);
+                delta[p] = (random() & 1) ? perturbation : -perturbation;
+                plusValues[p] = std::clamp(values[p] + delta[p], parameter.minValue, parameter.maxValue);
+                minusValues[p] = std::clamp(values[p] - delta[p], parameter.minValue, parameter.maxValue);
+            }
+            openingSeed = random();
+        }
+
+        //A pair of games from the same opening, each side plays both colors. The result is the wins minus the losses of the positive perturbation
+        Board opening = randomOpening(openingSeed);
+        SearchParameters plusParameters = toSearchParameters(plusValues), minusParameters = toSearchParameters(minusValues);
+        double plusScore = playGame(opening, plusParameters, minusParameters) + (1.0 - playGame(opening, minusParameters, plusParameters));
+        double result = 2.0 * plusScore - 2.0;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            //The step of each parameter is R * c * result in the direction of the perturbation, with R = a / c^2 decaying with the iterations
+            double stability = STABILITY_RATIO * iterations;
+            for (int p = 0; p < PARAMETERS.size(); ++p) {
+                const Parameter& parameter = PARAMETERS[p];
+                double perturbation = std::abs(delta[p]);
+                double a = parameter.endStep * parameter.endPerturbation * parameter.endPerturbation * std::pow(stability + iterations, ALPHA) / std::pow(stability + iteration, ALPHA);
+                double step = a / (perturbation * perturbation) * result * delta[p];
+                values[p] = std::clamp(values[p] + step, parameter.minValue, parameter.maxValue);
+            }
+            pairsScore += plusScore;
+            ++finishedIterations;
+
+            if (finishedIterations % CHECKPOINT_ITERATIONS == 0) {
+                if (!saveCheckpoint()) std::cerr << "ERROR: The checkpoint " << checkpointFile << " could not be written." << std::endl;
+                printProgress();
+            }
+        }
+    }
+}
+
+SearchParameters Spsa::toSearchParameters(const std::vector<double>& parameterValues) {
+    SearchParameters parameters;
+    for (int p = 0; p < PARAMETERS.size(); ++p) PARAMETERS[p].set(parameters, parameterValues[p]);
+    return parameters;
+}
+
+Board Spsa::randomOpening(uint64_t seed) {
+    std::mt19937_64 openingRandom(seed);
+    while (true) {
+        Board board;
+        board.setDefaulValues();
+        for (int ply = 0; ply < OPENING_PLIES && board.getBoardResult() == PLAYING; ++ply) {
+            const std::set<PieceMove>& moves = board.getCurrentLegalMoves();
+            auto it = moves.begin();
+            std::advance(it, openingRandom() % moves.size());
+            PieceMove move = *it;
+            board.movePiece(move);
+        }
+        if (board.getBoardResult() == PLAYING) return board;
+    }
+}
+
+double Spsa::playGame(const Board& opening, const SearchParameters& whiteParameters, const SearchParameters& blackParameters) const {
+    std::shared_ptr<Board> board = std::make_shared<Board>(opening);
+    std::unique_ptr<EngineV1> engines[2];
+    const SearchParameters* parameters[2] = {&whiteParameters, &blackParameters};
+    for (int col = WHITE; col <= BLACK; ++col) {
+        engines[col] = std::make_unique<EngineV1>(board, moveTime, false);
+        engines[col]->setSearchParameters(*parameters[col]);
+        engines[col]->setVerbose(false);
+    }
+
+    for (int ply = 0; ply < MAX_GAME_PLIES && board->getBoardResult() == PLAYING; ++ply) {
+        PieceMove move = engines[board->getMoveTurn()]->getMove();
+        board->movePiece(move);
+    }
+
+    //The player to move is the one checkmated, any other end is a draw
+    if (board->getBoardResult() == CHECKMATE) return board->getMoveTurn() == WHITE ? 0.0 : 1.0;
+    return 0.5;
+}
+
+bool Spsa::loadCheckpoint() {
+    std::ifstream file(checkpointFile);
+    if (!file) return false;
+
+    std::string name;
+    double value;
+    while (file >> name >> value) {
+        if (name == "iterations") {
+            finishedIterations = std::min(int(value), iterations);
+            nextIteration = finishedIterations + 1;
+            continue;
+        }
+        if (name == "score") {
+            pairsScore = value;
+            continue;
+        }
+        for (int p = 0; p < PARAMETERS.size(); ++p)
+            if (name == PARAMETERS[p].name) values[p] = std::clamp(value, PARAMETERS[p].minValue, PARAMETERS[p].maxValue);
+    }
+    return true;
+}
+
+bool Spsa::saveCheckpoint() const {
+    std::ofstream file(checkpointFile);
+    if (!file) return false;
+    file << "iterations " << finishedIterations << std::endl;
+    file << "score " << std::setprecision(10) << pairsScore << std::endl;
+    for (int p = 0; p < PARAMETERS.size(); ++p) file << PARAMETERS[p].name << " " << std::setprecision(10) << values[p] << std::endl;
+    return bool(file);
+}
+
+void Spsa::printProgress() const {
+    std::cout << "[INFO] Iteration " << finishedIterations << " of " << iterations;
+    if (finishedIterations > 0) std::cout << ", score of the positive perturbations: " << std::setprecision(3) << 50.0 * pairsScore / finishedIterations << "%";
+    std::cout << std::endl;
+    for (int p = 0; p < PARAMETERS.size(); ++p) std::cout << "[INFO]     " << PARAMETERS[p].name << ": " << std::setprecision(6) << values[p] << std::endl;
+}
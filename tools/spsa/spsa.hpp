@@ -0,0 +1,77 @@
+#ifndef SPSA_HH
+#define SPSA_HH
+
+#include "utils.hpp"
+#include "board.hpp"
+#include "engine_v1.hpp"
+
+//  SPSA tuning of the search parameters by self-play. Each iteration perturbs all the parameters at once, in a random direction, and plays a pair of games between the two opposite perturbations, each one with both colors from the same random opening. The parameters are moved towards the winner, and the steps get smaller as the tuning goes on. Several iterations are played at the same time, each thread with its own boards and engines, and all of them update the same parameters.
+//      SPSA: [https://www.chessprogramming.org/SPSA]
+//  The progress is saved in a checkpoint file, and the tuning is resumed from it if it exists.
+class Spsa {
+public:
+    //  Runs the tuner with the options of the command line
+    static void run(int argc, char* argv[]);
+
+private:
+    //  A tuned parameter: its range, and the size of its perturbations (c) and of its steps relative to them (r) at the end of the tuning. The ones at the start are derived from them, as fishtest does
+    struct Parameter {
+        const char* name;
+        double minValue;
+        double maxValue;
+        double endPerturbation;
+        double endStep;
+        double (*get)(const SearchParameters&);
+        void (*set)(SearchParameters&, double);
+    };
+
+    static const std::vector<Parameter> PARAMETERS;
+
+    //  Decay of the perturbations and the steps with the iterations, and the stability constant of the steps as a ratio of the iterations
+    static constexpr double ALPHA = 0.602;
+    static constexpr double GAMMA = 0.101;
+    static constexpr double STABILITY_RATIO = 0.1;
+
+    //  The games start after OPENING_PLIES random moves, and are drawn if they reach MAX_GAME_PLIES
+    static constexpr int OPENING_PLIES = 8;
+    static constexpr int MAX_GAME_PLIES = 300;
+
+    //  The checkpoint is written every CHECKPOINT_ITERATIONS finished iterations
+    static constexpr int CHECKPOINT_ITERATIONS = 10;
+
+    std::vector<double> values; //The current value of each parameter
+    int iterations; //The iterations of the whole tuning
+    int nextIteration; //The next iteration to be started, from 1
+    int finishedIterations;
+    double pairsScore; //The sum of the results of the pairs of games, for the positive perturbation
+    std::chrono::milliseconds moveTime;
+    int threads;
+    std::string checkpointFile;
+    std::mutex mutex; //Guards the parameters, the iteration counters and the random generator
+    std::mt19937_64 random;
+
+    Spsa(int iterations, std::chrono::milliseconds moveTime, int threads, const std::string& checkpointFile);
+
+    static void printUsage(const char* programName);
+
+    //  Plays iterations until all of them have been started
+    void worker();
+
+    //  Returns the search parameters with the values, rounded for the integer ones
+    static SearchParameters toSearchParameters(const std::vector<double>& parameterValues);
+
+    //  Returns a board after OPENING_PLIES random moves from the initial one, that isn't finished
+    static Board randomOpening(uint64_t seed);
+
+    //  Plays a game from the opening between engines with the parameters. Returns the result for white: 1 for a win, 0.5 for a draw and 0 for a loss
+    double playGame(const Board& opening, const SearchParameters& whiteParameters, const SearchParameters& blackParameters) const;
+
+    //  The checkpoint has the number of finished iterations, the sum of their scores and the value of each parameter, one for each line. Returns false if the file can't be read or written
+    bool loadCheckpoint();
+    bool saveCheckpoint() const;
+
+    //  Prints the finished iterations, the score of the positive perturbations and the current parameters
+    void printProgress() const;
+};
+
+#endif
@@ -0,0 +1,6 @@
+#include "tuner.hpp"
+
+int main(int argc, char* argv[]) {
+    Tuner::run(argc, argv);
+    return 0;
+}
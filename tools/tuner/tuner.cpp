@@ -0,0 +1,367 @@
+#include "tuner.hpp"
+
+void Tuner::run(int argc, char* argv[]) {
+    std::string datasetFile, outputFile = "pieceSquareValues.hpp";
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int epochs = 1000;
+    double learningRate = 1.0;
+
+    //Options for the command line
+    struct option longOptions[] = {
+        {"help",    no_argument,       0, 'h'},
+        {"dataset", required_argument, 0, 'd'},
+        {"output",  required_argument, 0, 'o'},
+        {"threads", required_argument, 0, 't'},
+        {"epochs",  required_argument, 0, 'e'},
+        {"rate",    required_argument, 0, 'r'},
+        {0, 0, 0, 0}
+    };
+    int opt;
+    int optionIndex = 0;
+    while ((opt = getopt_long(argc, argv, "hd:o:t:e:r:", longOptions, &optionIndex)) != -1) {
+        try {
+            switch (opt) {
+                case 'h': //Help
+                    printUsage(argv[0]);
+                    break;
+                case 'd': //Dataset
+                    datasetFile = optarg;
+                    break;
+                case 'o': //Output header
+                    outputFile = optarg;
+                    break;
+                case 't': //Threads
+                    threads = std::stoi(optarg);
+                    if (threads < 1) errorAndExit("ERROR: Invalid number of threads " + std::string(optarg) + ".");
+                    break;
+                case 'e': //Epochs
+                    epochs = std::stoi(optarg);
+                    if (epochs < 1) errorAndExit("ERROR: Invalid number of epochs " + std::string(optarg) + ".");
+                    break;
+                case 'r': //Learning rate
+                    learningRate = std::stod(optarg);
+                    if (learningRate < 0) errorAndExit("ERROR: Invalid learning rate " + std::string(optarg) + ".");
+                    break;
+                default:
+                    printUsage(argv[0]);
+                    break;
+            }
+        }
+        catch (const std::exception&) {
+            errorAndExit("ERROR: Invalid value " + std::string(optarg) + ".");
+        }
+    }
+    if (datasetFile == "") errorAndExit("ERROR: You must specify the dataset.");
+
+    Tuner tuner(threads);
+    if (!tuner.loadDataset(datasetFile)) errorAndExit("ERROR: The dataset " + datasetFile + " could not be loaded.");
+    if (tuner.positions.empty()) errorAndExit("ERROR: The dataset " + datasetFile + " has no valid positions.");
+
+    tuner.fitScalingConstant();
+    tuner.tune(epochs, learningRate, outputFile);
+}
+
+void Tuner::printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " --dataset <file> [options]" << std::endl;
+    std::cout << "Tune the material values and piece-square tables of the engine's evaluation on a dataset of positions labelled with the results of their games." << std::endl << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "    --help, -h: Displays this message." << std::endl;
+    std::cout << "    --dataset <file>, -d <file>: the positions, one for each line: a FEN and the result of its game as \"1-0\", \"0-1\" or \"1/2-1/2\", or as [1.0], [0.0] or [0.5]." << std::endl;
+    std::cout << "    --output <file>, -o <file>: the header written with the tuned values, to replace include/pieceSquareValues.hpp." << std::endl;
+    std::cout << "    --threads <threads>, -t <threads>: the threads that evaluate the positions." << std::endl;
+    std::cout << "    --epochs <epochs>, -e <epochs>: the passes of the gradient descent over the whole dataset." << std::endl;
+    std::cout << "    --rate <rate>, -r <rate>: the learning rate of the gradient descent, in centipawns. With a rate of 0 the current values are written unchanged." << std::endl;
+    std::cout << std::endl;
+    std::cout << "The default options are:" << std::endl;
+    std::cout << "    --output pieceSquareValues.hpp --threads <all the cores> --epochs 1000 --rate 1" << std::endl;
+
+    exit(0);
+}
+
+Tuner::Tuner(int threads) : threads(threads), scalingConstant(1.0) {
+    //The parameters start from the current values of the engine
+    const int (*midgame[6])[8] = {PieceSquareValues::MIDGAME_PAWN_TABLE, PieceSquareValues::MIDGAME_BISHOP_TABLE, PieceSquareValues::MIDGAME_KNIGHT_TABLE, PieceSquareValues::MIDGAME_ROOK_TABLE, PieceSquareValues::MIDGAME_QUEEN_TABLE, PieceSquareValues::MIDGAME_KING_TABLE};
+    const int (*endgame[6])[8] = {PieceSquareValues::ENDGAME_PAWN_TABLE, PieceSquareValues::ENDGAME_BISHOP_TABLE, PieceSquareValues::ENDGAME_KNIGHT_TABLE, PieceSquareValues::ENDGAME_ROOK_TABLE, PieceSquareValues::ENDGAME_QUEEN_TABLE, PieceSquareValues::ENDGAME_KING_TABLE};
+    parameters.resize(PARAMETERS);
+    for (int piece = 0; piece < 6; ++piece) {
+        for (int square = 0; square < 64; ++square) {
+            parameters[parameterIndex(0, piece, square)] = midgame[piece][square / 8][square % 8];
+            parameters[parameterIndex(1, piece, square)] = endgame[piece][square / 8][square % 8];
+        }
+        parameters[parameterIndex(0, piece, MATERIAL_PARAMETER)] = PieceSquareValues::MIDGAME_PIECE_VALUES[piece];
+        parameters[parameterIndex(1, piece, MATERIAL_PARAMETER)] = PieceSquareValues::ENDGAME_PIECE_VALUES[piece];
+    }
+}
+
+int Tuner::parameterIndex(int stage, int piece, int square) {
+    return (stage * 6 + piece) * PIECE_PARAMETERS + square;
+}
+
+bool Tuner::loadDataset(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file) return false;
+
+    //The zobrist table of the boards is initialized once, and the engines are created, before the threads use them
+    std::vector<std::shared_ptr<Board>> boards;
+    std::vector<std::unique_ptr<EngineV1>> engines;
+    for (int t = 0; t < threads; ++t) {
+        boards.push_back(std::make_shared<Board>());
+        boards.back()->setDefaulValues();
+        engines.push_back(std::make_unique<EngineV1>(boards.back(), std::chrono::milliseconds(0), false));
+    }
+
+    //The lines are read in batches, so only the text of one batch is kept in memory. Each thread parses a chunk of the batch, the chunks are joined in order
+    std::vector<std::string> lines;
+    std::vector<std::vector<Position>> chunkPositions(threads);
+    std::vector<std::vector<uint16_t>> chunkFeatures(threads);
+    size_t lineCount = 0;
+    while (true) {
+        for (std::string line; lines.size() < BATCH_LINES && std::getline(file, line);) lines.push_back(line);
+        if (lines.empty()) break;
+        lineCount += lines.size();
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                size_t begin = lines.size() * t / threads, end = lines.size() * (t + 1) / threads;
+                for (size_t k = begin; k < end; ++k) addPosition(lines[k], boards[t], *engines[t], chunkPositions[t], chunkFeatures[t]);
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+        lines.clear();
+
+        for (int t = 0; t < threads; ++t) {
+            uint32_t featuresOffset = features.size();
+            for (Position& position : chunkPositions[t]) {
+                position.firstFeature += featuresOffset;
+                positions.push_back(position);
+            }
+            features.insert(features.end(), chunkFeatures[t].begin(), chunkFeatures[t].end());
+            chunkPositions[t].clear();
+            chunkFeatures[t].clear();
+        }
+    }
+
+    std::cout << "[INFO] Positions loaded: " << positions.size() << " of " << lineCount << " lines" << std::endl;
+    return true;
+}
+
+void Tuner::addPosition(const std::string& line, const std::shared_ptr<Board>& board, EngineV1& engine, std::vector<Position>& chunkPositions, std::vector<uint16_t>& chunkFeatures) {
+    Position position;
+    if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos) position.result = 1;
+    else if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos) position.result = 2;
+    else if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos) position.result = 0;
+    else return;
+
+    std::vector<std::string> fields;
+    size_t start = line.find_first_not_of(" \t");
+    while (start != std::string::npos && fields.size() < 4) {
+        size_t end = line.find_first_of(" \t", start);
+        fields.push_back(line.substr(start, end - start));
+        start = line.find_first_not_of(" \t", end);
+    }
+    if (fields.size() < 4 || !validFEN(fields)) return;
+
+    //The move counters may be missing in the dataset, and they don't affect the evaluation
+    board->loadFEN(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " 0 1");
+    if (board->getBoardResult() != PLAYING || board->isInCheck()) return;
+
+    //The recognised endgames and the scaled ones aren't evaluated with the tables blended by the phase, so their gradient would be wrong
+    if (!engine.taperedStaticEvaluation()) return;
+
+    int evaluation = engine.staticEvaluation() * (board->getMoveTurn() == WHITE ? 1 : -1);
+    if (std::abs(evaluation) > MAX_EVALUATION) return;
+
+    position.firstFeature = chunkFeatures.size();
+    position.featureCount = 0;
+    position.phase = std::min(board->getPhase(), PieceSquareTables::MAX_PHASE);
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            PieceType pt = board->getPieceType(i, j);
+            if (pt == NONE) continue;
+            //The black pieces use the tables mirrored vertically
+            bool white = pieceColor(pt) == WHITE;
+            int square = (white ? i : 7 - i) * 8 + j;
+            chunkFeatures.push_back((white ? 0 : BLACK_FEATURE) | uint16_t((pt % 6) * 64 + square));
+            ++position.featureCount;
+        }
+    }
+
+    //The offset is what the tables don't evaluate, blended as the engine does
+    PackedScore score = board->getPieceSquareScore();
+    int tableEvaluation = (midgameValue(score) * position.phase + endgameValue(score) * (PieceSquareTables::MAX_PHASE - position.phase)) / PieceSquareTables::MAX_PHASE;
+    position.offset = evaluation - tableEvaluation;
+
+    chunkPositions.push_back(position);
+}
+
+bool Tuner::validFEN(const std::vector<std::string>& fields) {
+    int rank = 0, files = 0, whiteKings = 0, blackKings = 0;
+    for (char c : fields[0]) {
+        if (c == '/') {
+            if (files != 8) return false;
+            ++rank;
+            files = 0;
+        }
+        else if (c >= '1' && c <= '8') files += c - '0';
+        else if (std::string("PBNRQKpbnrqk").find(c) != std::string::npos) {
+            ++files;
+            if (c == 'K') ++whiteKings;
+            if (c == 'k') ++blackKings;
+        }
+        else return false;
+        if (files > 8) return false;
+    }
+    if (rank != 7 || files != 8 || whiteKings != 1 || blackKings != 1) return false;
+
+    if (fields[1] != "w" && fields[1] != "b") return false;
+
+    //The castling rights have to be in the KQkq order
+    if (fields[2] != "-") {
+        size_t k = 0;
+        for (char c : std::string("KQkq"))
+            if (k < fields[2].size() && fields[2][k] == c) ++k;
+        if (k != fields[2].size()) return false;
+    }
+
+    if (fields[3] != "-" && (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h' || fields[3][1] < '1' || fields[3][1] > '8')) return false;
+    return true;
+}
+
+double Tuner::evaluate(const Position& position) const {
+    double midgame = 0, endgame = 0;
+    for (uint32_t k = position.firstFeature; k < position.firstFeature + position.featureCount; ++k) {
+        int sign = (features[k] & BLACK_FEATURE) ? -1 : 1;
+        int piece = (features[k] & ~BLACK_FEATURE) / 64, square = features[k] % 64;
+        midgame += sign * (parameters[parameterIndex(0, piece, square)] + parameters[parameterIndex(0, piece, MATERIAL_PARAMETER)]);
+        endgame += sign * (parameters[parameterIndex(1, piece, square)] + parameters[parameterIndex(1, piece, MATERIAL_PARAMETER)]);
+    }
+    return position.offset + (midgame * position.phase + endgame * (PieceSquareTables::MAX_PHASE - position.phase)) / PieceSquareTables::MAX_PHASE;
+}
+
+double Tuner::sigmoid(double evaluation) const {
+    return 1.0 / (1.0 + std::pow(10.0, -scalingConstant * evaluation / 400.0));
+}
+
+double Tuner::computeLoss(std::vector<double>* gradient) const {
+    std::vector<double> threadLoss(threads, 0.0);
+    std::vector<std::vector<double>> threadGradient(gradient ? threads : 0, std::vector<double>(PARAMETERS, 0.0));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            size_t begin = positions.size() * t / threads, end = positions.size() * (t + 1) / threads;
+            for (size_t k = begin; k < end; ++k) {
+                const Position& position = positions[k];
+                double expected = sigmoid(evaluate(position));
+                double error = position.result / 2.0 - expected;
+                threadLoss[t] += error * error;
+                if (!gradient) continue;
+
+                //Derivative of the squared error with respect to the evaluation, then to each parameter of the pieces through the blend of the stages
+                double derivative = -2.0 * error * expected * (1.0 - expected) * scalingConstant * std::log(10.0) / 400.0;
+                double midgameWeight = derivative * position.phase / PieceSquareTables::MAX_PHASE;
+                double endgameWeight = derivative * (PieceSquareTables::MAX_PHASE - position.phase) / PieceSquareTables::MAX_PHASE;
+                for (uint32_t f = position.firstFeature; f < position.firstFeature + position.featureCount; ++f) {
+                    int sign = (features[f] & BLACK_FEATURE) ? -1 : 1;
+                    int piece = (features[f] & ~BLACK_FEATURE) / 64, square = features[f] % 64;
+                    threadGradient[t][parameterIndex(0, piece, square)] += sign * midgameWeight;
+                    threadGradient[t][parameterIndex(0, piece, MATERIAL_PARAMETER)] += sign * midgameWeight;
+                    threadGradient[t][parameterIndex(1, piece, square)] += sign * endgameWeight;
+                    threadGradient[t][parameterIndex(1, piece, MATERIAL_PARAMETER)] += sign * endgameWeight;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    double loss = 0;
+    for (int t = 0; t < threads; ++t) loss += threadLoss[t];
+    if (gradient) {
+        gradient->assign(PARAMETERS, 0.0);
+        for (int t = 0; t < threads; ++t)
+            for (int p = 0; p < PARAMETERS; ++p) (*gradient)[p] += threadGradient[t][p] / positions.size();
+    }
+    return loss / positions.size();
+}
+
+void Tuner::fitScalingConstant() {
+    //Scans around the best constant found with smaller steps each time
+    double bestLoss = computeLoss(nullptr);
+    double best = scalingConstant;
+    for (double step = 0.1; step >= 0.001; step /= 10) {
+        double center = best;
+        for (int k = -10; k <= 10; ++k) {
+            scalingConstant = center + k * step;
+            if (scalingConstant <= 0) continue;
+            double loss = computeLoss(nullptr);
+            if (loss < bestLoss) {
+                bestLoss = loss;
+                best = scalingConstant;
+            }
+        }
+    }
+    scalingConstant = best;
+    std::cout << "[INFO] Scaling constant: " << scalingConstant << ", loss: " << bestLoss << std::endl;
+}
+
+void Tuner::tune(int epochs, double learningRate, const std::string& outputFile) {
+    std::vector<double> gradient, momentum(PARAMETERS, 0.0), velocity(PARAMETERS, 0.0);
+    for (int epoch = 1; epoch <= epochs; ++epoch) {
+        double loss = computeLoss(&gradient);
+        double momentumCorrection = 1.0 - std::pow(ADAM_BETA1, epoch);
+        double velocityCorrection = 1.0 - std::pow(ADAM_BETA2, epoch);
+        for (int p = 0; p < PARAMETERS; ++p) {
+            momentum[p] = ADAM_BETA1 * momentum[p] + (1.0 - ADAM_BETA1) * gradient[p];
+            velocity[p] = ADAM_BETA2 * velocity[p] + (1.0 - ADAM_BETA2) * gradient[p] * gradient[p];
+            parameters[p] -= learningRate * (momentum[p] / momentumCorrection) / (std::sqrt(velocity[p] / velocityCorrection) + ADAM_EPSILON);
+        }
+
+        if (epoch % REPORT_EPOCHS == 0 || epoch == epochs) {
+            std::cout << "[INFO] Epoch " << epoch << ", loss: " << std::setprecision(8) << loss << std::endl;
+            if (!writeHeader(outputFile)) errorAndExit("ERROR: The file " + outputFile + " could not be written.");
+        }
+    }
+}
+
+bool Tuner::writeHeader(const std::string& fileName) const {
+    std::ofstream file(fileName);
+    if (!file) return false;
+
+    //The tables are written in the order of the original header
+    const char* pieceNames[6] = {"PAWN", "BISHOP", "KNIGHT", "ROOK", "QUEEN", "KING"};
+    const int tableOrder[6] = {0, 2, 1, 3, 4, 5};
+    const char* stageNames[2] = {"MIDGAME", "ENDGAME"};
+
+    file << "#ifndef PIECESQUAREVALUES_HH" << std::endl;
+    file << "#define PIECESQUAREVALUES_HH" << std::endl << std::endl;
+    file << "//  Material values and piece-square tables of the evaluation, with a midgame and an endgame set for each piece, see PieceSquareTables. The tables are written from white's view, the first row is the 8th rank." << std::endl;
+    file << "//  This file can be regenerated by the tuner with values fitted to a set of positions, see tools/tuner." << std::endl;
+    file << "class PieceSquareValues {" << std::endl;
+    file << "public:" << std::endl;
+    file << "    //  Indexed by the white PieceType" << std::endl;
+    for (int stage = 0; stage < 2; ++stage) {
+        file << "    static constexpr int " << stageNames[stage] << "_PIECE_VALUES[6] = {";
+        for (int piece = 0; piece < 6; ++piece) {
+            //The king has no material value
+            int value = piece == 5 ? 0 : std::lround(parameters[parameterIndex(stage, piece, MATERIAL_PARAMETER)]);
+            file << value << (piece < 5 ? ", " : "};");
+        }
+        file << std::endl;
+    }
+
+    file << std::endl;
+    for (int piece : tableOrder) {
+        for (int stage = 0; stage < 2; ++stage) {
+            file << "    static constexpr int " << stageNames[stage] << "_" << pieceNames[piece] << "_TABLE[8][8] = {";
+            for (int square = 0; square < 64; ++square) {
+                if (square % 8 == 0) file << std::endl << "        ";
+                file << std::setw(square % 8 == 0 ? 4 : 5) << std::lround(parameters[parameterIndex(stage, piece, square)]);
+                file << (square < 63 ? "," : "};");
+            }
+            file << std::endl;
+        }
+    }
+    file << "};" << std::endl << std::endl << "#endif" << std::endl;
+    return bool(file);
+}
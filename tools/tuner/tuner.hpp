@@ -0,0 +1,87 @@
+#ifndef TUNER_HH
+#define TUNER_HH
+
+#include "utils.hpp"
+#include "board.hpp"
+#include "engine_v1.hpp"
+
+//  Texel tuning of the material values and piece-square tables of the evaluation. The positions of a dataset, labelled with the result of their games, are loaded in batches into a compact array, and the values are fitted minimising the loss between the results and the sigmoid of the evaluations, with the Adam gradient descent. The loss and its gradient are computed in parallel, each thread over a chunk of the positions.
+//      Texel's Tuning Method: [https://www.chessprogramming.org/Texel%27s_Tuning_Method]
+//  The evaluation terms that aren't tuned are kept as a fixed offset of each position, computed once by the engine. The tuned values are written as a new pieceSquareValues.hpp, which replaces the one in the include directory.
+class Tuner {
+public:
+    //  Runs the tuner with the options of the command line
+    static void run(int argc, char* argv[]);
+
+private:
+    //  A position of the dataset. Its pieces are stored in the features array from firstFeature, each one as the index of its piece and square in the tables, with BLACK_FEATURE set for the black pieces
+    struct Position {
+        uint32_t firstFeature;
+        uint8_t featureCount;
+        uint8_t phase;
+        uint8_t result; //Half points of white: 0 for a loss, 1 for a draw and 2 for a win
+        int16_t offset; //The evaluation terms that aren't tuned, from white's perspective
+    };
+
+    //  The parameters of each stage, midgame and endgame, and each piece in the PieceType order: the 64 squares of its table, from white's view with a8 = 0, and its material value
+    static constexpr int PIECE_PARAMETERS = 65;
+    static constexpr int MATERIAL_PARAMETER = 64;
+    static constexpr int PARAMETERS = 2 * 6 * PIECE_PARAMETERS;
+    static constexpr uint16_t BLACK_FEATURE = 0x8000;
+
+    //  Positions evaluated beyond this are decided and are left out
+    static constexpr int MAX_EVALUATION = 2000;
+
+    //  The lines of the dataset read and parsed at a time
+    static constexpr size_t BATCH_LINES = 1 << 16;
+
+    //  Adam gradient descent
+    //      Stochastic Gradient Descent: [https://www.chessprogramming.org/Stochastic_Gradient_Descent]
+    static constexpr double ADAM_BETA1 = 0.9;
+    static constexpr double ADAM_BETA2 = 0.999;
+    static constexpr double ADAM_EPSILON = 1e-8;
+
+    //  The loss is reported and the values are written every REPORT_EPOCHS epochs
+    static constexpr int REPORT_EPOCHS = 50;
+
+    std::vector<Position> positions;
+    std::vector<uint16_t> features;
+    std::vector<double> parameters;
+    int threads;
+    double scalingConstant; //The K of the sigmoid, that maps the evaluations to the expected results
+
+    explicit Tuner(int threads);
+
+    static void printUsage(const char* programName);
+
+    static int parameterIndex(int stage, int piece, int square);
+
+    //  Loads the positions of the dataset, one for each line: a FEN, with or without the move counters, and the result of its game as "1-0", "0-1" or "1/2-1/2", or as [1.0], [0.0] or [0.5]. Returns false if the file can't be read
+    bool loadDataset(const std::string& fileName);
+
+    //  Parses a line of the dataset and adds its position. The lines with an unknown result or an invalid FEN, and the positions in check, already decided, or whose evaluation isn't the blend of the tables, as the recognised and scaled endgames, are skipped
+    void addPosition(const std::string& line, const std::shared_ptr<Board>& board, EngineV1& engine, std::vector<Position>& chunkPositions, std::vector<uint16_t>& chunkFeatures);
+
+    //  Returns true if the fields can be loaded by the board: the piece placement with one king of each color, the active color, the castling rights and the en passant square
+    static bool validFEN(const std::vector<std::string>& fields);
+
+    //  Returns the evaluation of the position with the current parameters, from white's perspective
+    double evaluate(const Position& position) const;
+
+    //  Returns the expected result of an evaluation, from 0 to 1
+    double sigmoid(double evaluation) const;
+
+    //  Returns the mean squared error of the expected results of the positions. If gradient isn't null, it gets the gradient of the error with respect to each parameter
+    double computeLoss(std::vector<double>* gradient) const;
+
+    //  Fits the scaling constant of the sigmoid to the current parameters, before tuning them
+    void fitScalingConstant();
+
+    //  Runs the gradient descent for the epochs, writing the tuned values to the output file as it goes
+    void tune(int epochs, double learningRate, const std::string& outputFile);
+
+    //  Writes the current parameters, rounded, as the pieceSquareValues.hpp header. Returns false if the file can't be written
+    bool writeHeader(const std::string& fileName) const;
+};
+
+#endif